@@ -0,0 +1,574 @@
+#include "vcs/Repository.h"
+#include "vcs/FileHandler.h"
+#include "vcs/FileTree.h"
+#include "vcs/TreePool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+// Benchmarks for the vcs core library. Every benchmark runs against a
+// synthetic repository generated from a fixed seed under bench_data/, so
+// two builds measured on the same machine see the same histories. Each
+// benchmark is repeated and its median reported; --json writes the results
+// and --baseline fails the run when a median grew past the tolerance.
+//
+// The default scales finish in a few minutes. --large adds the ranges
+// production repositories reach (up to 1M files and 100k commits), which
+// take far longer and a few GB of disk.
+
+static void printUsage() {
+    std::cerr << "Usage: benchmark [options]\n"
+              << "  --filter TEXT       only benchmarks whose name contains TEXT\n"
+              << "  --large             add the large scales (1M files, 100k commits)\n"
+              << "  --repetitions N     runs per benchmark, median reported (default 5)\n"
+              << "  --min-time SECONDS  minimum measured time per run (default 0.2)\n"
+              << "  --json FILE         write the results as JSON\n"
+              << "  --baseline FILE     compare with an earlier --json file\n"
+              << "  --tolerance PERCENT slowdown allowed against the baseline (default 10)\n"
+              << "  --list              print the benchmark names and exit\n";
+}
+
+// splitmix64: the same seed gives the same repository on every platform
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed) {
+    }
+    
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    
+    size_t below(size_t bound) {
+        return static_cast<size_t>(next() % bound);
+    }
+};
+
+static const uint64_t SEED = 20240611;
+
+// Files spread over a source-like tree: 16 top-level modules of 64
+// directories each, so large repositories get realistic directory fan-out
+static std::string syntheticPath(size_t index) {
+    return "src/mod" + std::to_string(index % 16) + "/dir" + std::to_string((index / 16) % 64) +
+           "/file" + std::to_string(index) + ".cpp";
+}
+
+static std::string syntheticContent(Random& random, size_t index, size_t revision) {
+    std::string content = "// file " + std::to_string(index) + " revision " + std::to_string(revision) + "\n";
+    size_t lines = 8 + random.below(24);
+    for (size_t i = 0; i < lines; i++) {
+        content += "int value" + std::to_string(i) + " = " + std::to_string(random.next() % 100000) + ";\n";
+    }
+    return content;
+}
+
+// A repository with files files, then commits - 1 more commits that each
+// edit about churn of them
+struct RepoShape {
+    size_t files;
+    size_t commits;
+    double churn;
+};
+
+static void generateRepository(const std::string& dataPath, const RepoShape& shape) {
+    std::filesystem::remove_all(dataPath);
+    std::filesystem::create_directories(dataPath);
+    
+    Random random(SEED);
+    Repository repo(dataPath);
+    repo.initializeRepo();
+    
+    // Commits share one journal flush, as in a bulk import
+    repo.beginBatch();
+    for (size_t i = 0; i < shape.files; i++) {
+        repo.addFile(syntheticPath(i), syntheticContent(random, i, 0));
+    }
+    repo.commitChanges("Import");
+    
+    size_t edits = std::max<size_t>(1, static_cast<size_t>(shape.files * shape.churn));
+    for (size_t commit = 1; commit < shape.commits; commit++) {
+        for (size_t i = 0; i < edits; i++) {
+            size_t file = random.below(shape.files);
+            repo.addFile(syntheticPath(file), syntheticContent(random, file, commit));
+        }
+        repo.commitChanges("Change " + std::to_string(commit));
+    }
+    repo.endBatch();
+}
+
+// Generated repositories are built once per run and shared by the
+// benchmarks that only read them
+static std::string getRepository(const RepoShape& shape, bool packed = false) {
+    static std::map<std::string, std::string> generated;
+    std::string key = std::to_string(shape.files) + "x" + std::to_string(shape.commits) + (packed ? "-packed" : "");
+    auto it = generated.find(key);
+    if (it != generated.end()) {
+        return it->second;
+    }
+    
+    std::string dataPath = "bench_data/" + key;
+    std::cerr << "generating " << key << "..." << std::endl;
+    generateRepository(dataPath, shape);
+    if (packed) {
+        Repository repo(dataPath);
+        size_t packedCount;
+        repo.loadRepository();
+        repo.repack(packedCount);
+    }
+    generated[key] = dataPath;
+    return dataPath;
+}
+
+
+// Times the loop of one benchmark run. The loop runs until both an
+// iteration and the minimum time are done; pauseTiming excludes per
+// iteration setup from the measurement.
+class BenchState {
+private:
+    typedef std::chrono::steady_clock Clock;
+    
+    const std::vector<long>& args;
+    double minTime;
+    size_t iterations;
+    bool started;
+    bool paused;
+    Clock::time_point resumed;
+    double elapsed;         // Measured seconds, pauses excluded
+
+public:
+    BenchState(const std::vector<long>& benchArgs, double minSeconds)
+        : args(benchArgs), minTime(minSeconds), iterations(0), started(false), paused(false), elapsed(0) {
+    }
+    
+    long arg(size_t index) const {
+        return args[index];
+    }
+    
+    bool keepRunning() {
+        if (!started) {
+            started = true;
+            resumed = Clock::now();
+            return true;
+        }
+        iterations++;
+        double total = elapsed + (paused ? 0.0 : secondsSince(resumed));
+        return total < minTime && iterations < 1000000;
+    }
+    
+    void pauseTiming() {
+        if (!paused) {
+            elapsed += secondsSince(resumed);
+            paused = true;
+        }
+    }
+    
+    void resumeTiming() {
+        if (paused) {
+            resumed = Clock::now();
+            paused = false;
+        }
+    }
+    
+    size_t getIterations() const {
+        return iterations;
+    }
+    
+    double getNanosecondsPerIteration() {
+        pauseTiming();
+        return iterations ? elapsed * 1e9 / iterations : 0.0;
+    }
+
+private:
+    static double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(BenchState&)> run;
+    std::vector<long> args;
+};
+
+struct BenchResult {
+    std::string name;
+    size_t iterations;
+    double medianNs;
+    double minNs;
+};
+
+// One benchmark per argument set, named "base/label:value/..."
+static void addBenchmark(std::vector<Benchmark>& benchmarks, const std::string& name,
+                         const std::vector<std::string>& labels, const std::vector<std::vector<long>>& argSets,
+                         const std::function<void(BenchState&)>& run) {
+    for (const std::vector<long>& args : argSets) {
+        std::string fullName = name;
+        for (size_t i = 0; i < args.size(); i++) {
+            fullName += "/" + labels[i] + ":" + std::to_string(args[i]);
+        }
+        benchmarks.push_back({ fullName, run, args });
+    }
+}
+
+// A commit of synthetic files, built straight into trees without touching disk
+static Commit* makeSyntheticCommit(Arena& arena, TreePool& trees, ObjectStore* store, int versionId,
+                                   size_t files, size_t revision) {
+    Commit* commit = arena.create<Commit>(arena, trees, versionId, "Synthetic", store);
+    std::vector<std::string> paths(files);
+    std::vector<std::string> blobIds(files);
+    std::vector<TreeEdit> edits(files);
+    for (size_t i = 0; i < files; i++) {
+        paths[i] = syntheticPath(i);
+        std::ostringstream blobId;
+        blobId << std::hex << std::setw(40) << std::setfill('0') << (i * 2654435761ULL + revision);
+        blobIds[i] = blobId.str();
+        edits[i].path = paths[i];
+        edits[i].file.blobId = blobIds[i];
+        edits[i].file.size = 100 + i % 1000;
+        edits[i].remove = false;
+    }
+    commit->files = trees.build(edits);
+    return commit;
+}
+
+static std::vector<Benchmark> registerBenchmarks(bool large) {
+    std::vector<Benchmark> benchmarks;
+    std::vector<std::vector<long>> fileScales = { {10}, {1000}, {100000} };
+    if (large) {
+        fileScales.push_back({1000000});
+    }
+    std::vector<std::vector<long>> historyScales = { {10, 100}, {1000, 100} };
+    if (large) {
+        historyScales.push_back({100000, 100});
+    }
+    
+    // Commit ten edited files on top of a repository of the given size
+    addBenchmark(benchmarks, "commitChanges", { "files" }, fileScales, [](BenchState& state) {
+        // Only this benchmark uses single-commit repositories, so it may add to them
+        size_t files = static_cast<size_t>(state.arg(0));
+        RepoShape shape = { files, 1, 0.0 };
+        Repository repo(getRepository(shape));
+        repo.loadRepository();
+        Random random(SEED + 1);
+        size_t revision = 1;
+        while (state.keepRunning()) {
+            state.pauseTiming();
+            for (size_t i = 0; i < std::min<size_t>(files, 10); i++) {
+                size_t file = random.below(files);
+                repo.addFile(syntheticPath(file), syntheticContent(random, file, revision));
+            }
+            revision++;
+            state.resumeTiming();
+            repo.commitChanges("Benchmark commit");
+        }
+    });
+    
+    // Write one commit file and index it
+    addBenchmark(benchmarks, "saveCommit", { "files" }, fileScales, [](BenchState& state) {
+        std::string dataPath = "bench_data/save";
+        std::filesystem::remove_all(dataPath);
+        std::filesystem::create_directories(dataPath + "/commits");
+        
+        FileHandler handler(dataPath);
+        Arena arena;
+        TreePool trees;
+        Commit* commit = makeSyntheticCommit(arena, trees, handler.getObjectStore(), 1,
+                                             static_cast<size_t>(state.arg(0)), 0);
+        while (state.keepRunning()) {
+            handler.saveCommit(commit);
+        }
+    });
+    
+    // Read one commit file back into a fresh arena and tree pool
+    addBenchmark(benchmarks, "loadCommit", { "files" }, fileScales, [](BenchState& state) {
+        std::string dataPath = "bench_data/load";
+        std::filesystem::remove_all(dataPath);
+        std::filesystem::create_directories(dataPath + "/commits");
+        
+        FileHandler handler(dataPath);
+        {
+            Arena arena;
+            TreePool trees;
+            handler.saveCommit(makeSyntheticCommit(arena, trees, handler.getObjectStore(), 1,
+                                                   static_cast<size_t>(state.arg(0)), 0));
+        }
+        Arena arena;
+        TreePool trees;
+        while (state.keepRunning()) {
+            handler.loadCommit(1, arena, trees);
+            state.pauseTiming();
+            trees.clear();
+            arena.release();
+            state.resumeTiming();
+        }
+    });
+    
+    // Open a repository: metadata, index, every commit and the working index
+    for (int packed = 0; packed <= 1; packed++) {
+        addBenchmark(benchmarks, packed ? "loadRepository/packed" : "loadRepository", { "commits", "files" },
+                     historyScales, [packed](BenchState& state) {
+            RepoShape shape = { static_cast<size_t>(state.arg(1)), static_cast<size_t>(state.arg(0)), 0.05 };
+            std::string dataPath = getRepository(shape, packed != 0);
+            while (state.keepRunning()) {
+                std::unique_ptr<Repository> repo(new Repository(dataPath));
+                repo->loadRepository();
+                // Freeing the history is not part of loading it
+                state.pauseTiming();
+                repo.reset();
+                state.resumeTiming();
+            }
+        });
+    }
+    
+    // Move between the oldest and the newest commit
+    addBenchmark(benchmarks, "revertToCommit", { "commits", "files" }, historyScales, [](BenchState& state) {
+        RepoShape shape = { static_cast<size_t>(state.arg(1)), static_cast<size_t>(state.arg(0)), 0.05 };
+        Repository repo(getRepository(shape));
+        repo.loadRepository();
+        int newest = repo.getTotalCommits();
+        bool toOldest = true;
+        while (state.keepRunning()) {
+            repo.revertToCommit(toOldest ? 1 : newest);
+            toOldest = !toOldest;
+        }
+    });
+    
+    // Look up commits by id in random order
+    addBenchmark(benchmarks, "findCommitById", { "commits", "files" }, historyScales, [](BenchState& state) {
+        RepoShape shape = { static_cast<size_t>(state.arg(1)), static_cast<size_t>(state.arg(0)), 0.05 };
+        Repository repo(getRepository(shape));
+        repo.loadRepository();
+        int total = repo.getTotalCommits();
+        Random random(SEED + 2);
+        Commit* found = nullptr;
+        while (state.keepRunning()) {
+            found = repo.getCommitById(1 + static_cast<int>(random.below(static_cast<size_t>(total))));
+        }
+        if (!found) {
+            std::cerr << "findCommitById: lookup failed" << std::endl;
+        }
+    });
+    
+    // Ask whether a random commit is an ancestor of the newest one
+    addBenchmark(benchmarks, "isAncestor", { "commits", "files" }, historyScales, [](BenchState& state) {
+        RepoShape shape = { static_cast<size_t>(state.arg(1)), static_cast<size_t>(state.arg(0)), 0.05 };
+        Repository repo(getRepository(shape));
+        repo.loadRepository();
+        int total = repo.getTotalCommits();
+        Random random(SEED + 3);
+        bool found = true;
+        while (state.keepRunning()) {
+            found = repo.isAncestor(1 + static_cast<int>(random.below(static_cast<size_t>(total))), total) && found;
+        }
+        if (!found) {
+            std::cerr << "isAncestor: ancestor not found" << std::endl;
+        }
+    });
+
+    // List the differences between two commits that share all but 1% of their files
+    addBenchmark(benchmarks, "compare", { "files" }, fileScales, [](BenchState& state) {
+        size_t files = static_cast<size_t>(state.arg(0));
+        Arena arena;
+        TreePool trees;
+        Commit* before = makeSyntheticCommit(arena, trees, nullptr, 1, files, 0);
+        
+        Random random(SEED + 3);
+        std::vector<std::string> paths;
+        std::vector<TreeEdit> edits;
+        size_t changes = std::max<size_t>(1, files / 100);
+        for (size_t i = 0; i < changes; i++) {
+            paths.push_back(syntheticPath(random.below(files)));
+        }
+        for (const std::string& path : paths) {
+            TreeEdit edit = { path, { "ffffffffffffffffffffffffffffffffffffffff", 1 }, false };
+            edits.push_back(edit);
+        }
+        FileTree after = trees.apply(before->files, edits);
+        
+        size_t visited = 0;
+        while (state.keepRunning()) {
+            FileTree::compare(before->files, after, [&visited](std::string_view, const FileEntry*, const FileEntry*) {
+                visited++;
+            });
+        }
+        if (visited == 0) {
+            std::cerr << "compare: no changes found" << std::endl;
+        }
+    });
+    
+    return benchmarks;
+}
+
+
+static BenchResult runBenchmark(const Benchmark& benchmark, int repetitions, double minTime) {
+    std::vector<double> times;
+    size_t iterations = 0;
+    for (int i = 0; i < repetitions; i++) {
+        BenchState state(benchmark.args, minTime);
+        benchmark.run(state);
+        times.push_back(state.getNanosecondsPerIteration());
+        iterations += state.getIterations();
+    }
+    std::sort(times.begin(), times.end());
+    
+    BenchResult result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.medianNs = times[times.size() / 2];
+    result.minNs = times.front();
+    return result;
+}
+
+static std::string formatTime(double ns) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(ns < 10 ? 2 : 0) << ns << " ns";
+    return out.str();
+}
+
+static bool writeJson(const std::string& path, const std::vector<BenchResult>& results, int repetitions) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    // One benchmark per line, which is all readBaseline expects
+    file << "{\n  \"repetitions\": " << repetitions << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        file << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+             << ", \"median_ns\": " << std::fixed << std::setprecision(2) << result.medianNs
+             << ", \"min_ns\": " << result.minNs << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return file.good();
+}
+
+// name -> median from a file written by writeJson
+static bool readBaseline(const std::string& path, std::map<std::string, double>& medians) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t median = line.find("\"median_ns\": ");
+        if (name == std::string::npos || median == std::string::npos) {
+            continue;
+        }
+        name += 9;
+        medians[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + median + 13);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    bool large = false;
+    bool list = false;
+    int repetitions = 5;
+    double minTime = 0.2;
+    double tolerance = 10.0;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "--large") {
+            large = true;
+        } else if (arg == "--list") {
+            list = true;
+        } else if (arg == "--repetitions" && hasValue) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--min-time" && hasValue) {
+            minTime = std::atof(argv[++i]);
+        } else if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            tolerance = std::atof(argv[++i]);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    
+    std::map<std::string, double> baseline;
+    if (!baselinePath.empty() && !readBaseline(baselinePath, baseline)) {
+        std::cerr << "error: cannot read " << baselinePath << std::endl;
+        return 2;
+    }
+    
+    std::vector<Benchmark> benchmarks = registerBenchmarks(large);
+    if (list) {
+        for (const Benchmark& benchmark : benchmarks) {
+            std::cout << benchmark.name << "\n";
+        }
+        return 0;
+    }
+    
+    std::filesystem::remove_all("bench_data");
+    std::filesystem::create_directories("bench_data");
+    
+    std::cout << std::left << std::setw(44) << "Benchmark" << std::right << std::setw(16) << "Median"
+              << std::setw(16) << "Min" << std::setw(12) << "Iterations" << "\n"
+              << std::string(88, '-') << std::endl;
+    
+    std::vector<BenchResult> results;
+    int regressions = 0;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        BenchResult result = runBenchmark(benchmark, repetitions, minTime);
+        results.push_back(result);
+        
+        std::cout << std::left << std::setw(44) << result.name << std::right << std::setw(16)
+                  << formatTime(result.medianNs) << std::setw(16) << formatTime(result.minNs)
+                  << std::setw(12) << result.iterations;
+        auto it = baseline.find(result.name);
+        if (it != baseline.end() && it->second > 0) {
+            double change = (result.medianNs / it->second - 1.0) * 100.0;
+            std::cout << "  " << std::showpos << std::fixed << std::setprecision(1) << change << "%" << std::noshowpos;
+            if (change > tolerance) {
+                std::cout << " REGRESSION";
+                regressions++;
+            }
+        }
+        std::cout << std::endl;
+    }
+    
+    std::filesystem::remove_all("bench_data");
+    
+    if (!jsonPath.empty() && !writeJson(jsonPath, results, repetitions)) {
+        std::cerr << "error: cannot write " << jsonPath << std::endl;
+        return 2;
+    }
+    if (regressions > 0) {
+        std::cerr << regressions << " benchmark(s) slower than the baseline by more than "
+                  << tolerance << "%" << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
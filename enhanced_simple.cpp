@@ -10,6 +10,8 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include "vcs/Repository.h"
+#include "vcs/Diff.h"
+#include "vcs/LineScanner.h"
 
 class RepositoryManager {
 private:
@@ -22,6 +24,10 @@ public:
     
     ~RepositoryManager() {
         if (currentRepo) {
+            // Keep uncommitted edits for the next session
+            if (currentRepo->isInitialized()) {
+                currentRepo->saveRepository();
+            }
             delete currentRepo;
         }
     }
@@ -75,8 +81,11 @@ public:
             return false;
         }
         
-        // Clean up current repository
+        // Clean up current repository, keeping its uncommitted edits
         if (currentRepo) {
+            if (currentRepo->isInitialized()) {
+                currentRepo->saveRepository();
+            }
             delete currentRepo;
         }
         
@@ -335,14 +344,9 @@ private:
         
         std::string selectedRepo = repos[repoChoice - 1];
         
+        // switchToRepository already loads the repository data
         if (repoManager.switchToRepository(selectedRepo)) {
             std::cout << "[SUCCESS] Switched to repository '" << selectedRepo << "'" << std::endl;
-            
-            // Try to load repository data
-            Repository* repo = repoManager.getCurrentRepository();
-            if (repo) {
-                repo->loadRepository();
-            }
         } else {
             std::cout << "[ERROR] Failed to switch to repository!" << std::endl;
         }
@@ -507,7 +511,7 @@ private:
             std::cout << "[SUCCESS] File '" << filename << "' added to repository '" 
                       << repoManager.getCurrentRepoName() << "'!" << std::endl;
             std::cout << "  Content length: " << content.length() << " characters" << std::endl;
-            std::cout << "  Lines: " << std::count(content.begin(), content.end(), '\n') << std::endl;
+            std::cout << "  Lines: " << LineScanner::countNewlines(content) << std::endl;
         } else {
             std::cout << "[ERROR] Failed to add file!" << std::endl;
         }
@@ -613,7 +617,7 @@ private:
         
         for (size_t i = 0; i < files.size(); i++) {
             std::string content = repo->getFileContent(files[i]);
-            int lines = std::count(content.begin(), content.end(), '\n');
+            size_t lines = LineScanner::countNewlines(content);
             
             std::cout << "| " << std::setw(3) << (i + 1) << " | " 
                       << std::setw(23) << std::left << files[i] << " | "
@@ -666,10 +670,18 @@ private:
             return;
         }
         
-        std::cout << "Files to be committed in '" << repoManager.getCurrentRepoName() << "':" << std::endl;
-        for (const auto& file : files) {
-            std::string content = repo->getFileContent(file);
-            std::cout << "  [+] " << file << " (" << content.length() << " chars)" << std::endl;
+        std::vector<FileChange> changes = repo->getStatus();
+        std::cout << "Changes to be committed in '" << repoManager.getCurrentRepoName() << "':" << std::endl;
+        for (const auto& change : changes) {
+            if (change.status == FILE_REMOVED) {
+                std::cout << "  [-] " << change.filename << std::endl;
+                continue;
+            }
+            std::cout << "  " << (change.status == FILE_ADDED ? "[+] " : "[M] ") << change.filename
+                      << " (" << repo->getFileSize(change.filename) << " chars)" << std::endl;
+        }
+        if (changes.empty()) {
+            std::cout << "  (no changes since the last commit)" << std::endl;
         }
         
         std::string message;
@@ -725,7 +737,7 @@ private:
             
             // Show file details
             for (const auto& file : commit->files) {
-                std::string fileInfo = "  -> " + file.first + " (" + std::to_string(file.second.length()) + " chars)";
+                std::string fileInfo = "  -> " + std::string(file.first) + " (" + std::to_string(file.second.size) + " chars)";
                 std::cout << "| " << std::setw(59) << std::left << fileInfo << " |" << std::endl;
             }
             
@@ -791,13 +803,13 @@ private:
             
             std::vector<std::string> files = repo->getWorkingFiles();
             std::cout << "Working Files: " << files.size() << std::endl;
+            std::cout << "Changed Files: " << repo->getStatus().size() << std::endl;
             
             if (!files.empty()) {
                 std::cout << "\n+--- Working Directory Files ---+" << std::endl;
                 for (const auto& file : files) {
-                    std::string content = repo->getFileContent(file);
                     std::cout << "| " << std::setw(25) << std::left << file 
-                              << " | " << std::setw(6) << content.length() << " chars |" << std::endl;
+                              << " | " << std::setw(6) << repo->getFileSize(file) << " chars |" << std::endl;
                 }
                 std::cout << "+--------------------------------+" << std::endl;
             }
@@ -870,11 +882,14 @@ private:
         if (content.empty()) {
             std::cout << "| (empty file)                                     |" << std::endl;
         } else {
-            std::istringstream iss(content);
-            std::string line;
-            int lineNum = 1;
+            std::vector<std::string_view> lines;
+            LineScanner::splitLines(content, lines);
             
-            while (std::getline(iss, line)) {
+            int lineNum = 1;
+            for (std::string_view line : lines) {
+                if (!line.empty() && line.back() == '\n') {
+                    line.remove_suffix(1);
+                }
                 std::cout << std::setw(3) << lineNum << "| " << line << std::endl;
                 lineNum++;
             }
@@ -882,7 +897,7 @@ private:
         
         std::cout << "+--------------------------------------------------+" << std::endl;
         std::cout << "File size: " << content.length() << " characters" << std::endl;
-        std::cout << "Lines: " << std::count(content.begin(), content.end(), '\n') << std::endl;
+        std::cout << "Lines: " << LineScanner::countNewlines(content) << std::endl;
     }
     
     void compareVersions() {
@@ -917,13 +932,8 @@ private:
         std::cout << "Enter second commit ID: ";
         int commit2 = getChoice();
         
-        Commit* c1 = nullptr;
-        Commit* c2 = nullptr;
-        
-        for (const auto& commit : history) {
-            if (commit->versionId == commit1) c1 = commit;
-            if (commit->versionId == commit2) c2 = commit;
-        }
+        Commit* c1 = repo->getCommitById(commit1);
+        Commit* c2 = repo->getCommitById(commit2);
         
         if (!c1 || !c2) {
             std::cout << "Invalid commit IDs!" << std::endl;
@@ -934,32 +944,40 @@ private:
         
         // Find common files
         for (const auto& file1 : c1->files) {
-            auto it = c2->files.find(file1.first);
-            if (it != c2->files.end()) {
-                std::cout << "\nFile: " << file1.first << std::endl;
-                std::cout << "Commit #" << commit1 << " size: " << file1.second.length() << " chars" << std::endl;
-                std::cout << "Commit #" << commit2 << " size: " << it->second.length() << " chars" << std::endl;
+            const FileEntry* file2 = c2->files.find(file1.first);
+            if (file2) {
+                std::string filename(file1.first);
+                std::cout << "\nFile: " << filename << std::endl;
+                std::cout << "Commit #" << commit1 << " size: " << file1.second.size << " chars" << std::endl;
+                std::cout << "Commit #" << commit2 << " size: " << file2->size << " chars" << std::endl;
                 
-                if (file1.second == it->second) {
+                // Same blob id means same content - no need to load either file
+                if (file1.second.blobId == file2->blobId) {
                     std::cout << "Status: [IDENTICAL]" << std::endl;
                 } else {
                     std::cout << "Status: [DIFFERENT]" << std::endl;
-                    int diff = static_cast<int>(it->second.length()) - static_cast<int>(file1.second.length());
+                    int diff = static_cast<int>(file2->size) - static_cast<int>(file1.second.size);
                     std::cout << "Size change: " << (diff >= 0 ? "+" : "") << diff << " characters" << std::endl;
+                    
+                    // Line-level diff of the two versions
+                    DiffResult result = Diff::diffLines(c1->getFile(filename), c2->getFile(filename));
+                    std::cout << "Lines: +" << result.linesAdded << " -" << result.linesRemoved << std::endl;
+                    std::cout << Diff::formatUnified("#" + std::to_string(commit1) + "/" + filename,
+                                                     "#" + std::to_string(commit2) + "/" + filename, result);
                 }
             }
         }
         
         // Files only in commit1
         for (const auto& file1 : c1->files) {
-            if (c2->files.find(file1.first) == c2->files.end()) {
+            if (!c2->files.find(file1.first)) {
                 std::cout << "\nFile: " << file1.first << " (only in commit #" << commit1 << ")" << std::endl;
             }
         }
         
         // Files only in commit2
         for (const auto& file2 : c2->files) {
-            if (c1->files.find(file2.first) == c1->files.end()) {
+            if (!c1->files.find(file2.first)) {
                 std::cout << "\nFile: " << file2.first << " (only in commit #" << commit2 << ")" << std::endl;
             }
         }
@@ -0,0 +1,254 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "vcs/RepositoryHost.h"
+#include "vcs/RequestHandler.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// Non-interactive front end. One-shot commands map onto the same requests
+// the server answers; batch mode reads a stream of requests from stdin and
+// runs them all against repositories loaded once.
+static void printUsage() {
+    std::cerr << "Usage: minivcs <command> --repo NAME [arguments]\n"
+              << "  init   --repo NAME\n"
+              << "  add    --repo NAME FILE [SOURCE]   content from SOURCE (default FILE, - for stdin)\n"
+              << "  commit --repo NAME -m MESSAGE\n"
+              << "  status --repo NAME\n"
+              << "  files  --repo NAME\n"
+              << "  log    --repo NAME\n"
+              << "  cat    --repo NAME FILE [VERSION]\n"
+              << "  diff   --repo NAME FILE FROM TO\n"
+              << "  revert --repo NAME VERSION       detaches from the branch unless VERSION is its tip\n"
+              << "  branch --repo NAME [BRANCH [VERSION]]  list branches, or create one\n"
+              << "  switch --repo NAME BRANCH        keeps uncommitted edits\n"
+              << "  merge  --repo NAME BRANCH        conflicts are left for the next commit\n"
+              << "  search --repo NAME TEXT          committed lines containing TEXT, in every version\n"
+              << "  grep   --repo NAME REGEX         the same for a regular expression\n"
+              << "  repack --repo NAME               move loose commit files into one pack file\n"
+              << "  batch  [--repo NAME]             requests on stdin, replies on stdout\n"
+              << "\n"
+              << "Batch requests use the server protocol (see vcs/RequestHandler.h). With\n"
+              << "--repo the repository name is left out of each request, and the commits\n"
+              << "of the whole batch share one journal flush.\n";
+}
+
+static bool readSource(const std::string& path, std::string& content) {
+    std::istream* input = &std::cin;
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        input = &file;
+    }
+    
+    std::stringstream buffer;
+    buffer << input->rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+// Add the name to repositories.txt so the console app lists it too
+static void registerRepository(const std::string& name) {
+    std::ifstream listIn("repositories.txt");
+    std::string line;
+    while (std::getline(listIn, line)) {
+        if (line == name) {
+            return;
+        }
+    }
+    listIn.close();
+    
+    std::ofstream listOut("repositories.txt", std::ios::app);
+    listOut << name << std::endl;
+}
+
+// Insert the batch's repository after the command word
+static std::string qualifyRequest(const std::string& line, const std::string& repoName) {
+    size_t start = line.find_first_not_of(' ');
+    if (repoName.empty() || start == std::string::npos) {
+        return line;
+    }
+    size_t end = line.find(' ', start);
+    std::string command = line.substr(start, end - start);
+    if (command == "PING" || command == "SHUTDOWN") {
+        return line;
+    }
+    return command + " " + repoName + (end == std::string::npos ? "" : line.substr(end));
+}
+
+// Read a request's content in bounded chunks, so a bogus size in the request
+// line ends at end of input instead of allocating it all up front
+static bool readPayload(size_t size, std::string& payload) {
+    static const size_t CHUNK_SIZE = 1u << 20;
+    payload.clear();
+    while (payload.size() < size) {
+        size_t offset = payload.size();
+        size_t chunk = std::min(size - offset, CHUNK_SIZE);
+        payload.resize(offset + chunk);
+        if (!std::cin.read(&payload[offset], chunk)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int runBatch(RepositoryHost& host, const std::string& repoName) {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::ios::sync_with_stdio(false);
+    
+    RequestHandler handler(host);
+    // A repository that does not exist yet opens its batch once INIT has
+    // created it
+    bool batchOpen = false;
+    auto openBatch = [&]() {
+        if (!repoName.empty() && !batchOpen) {
+            batchOpen = host.withWriter(repoName, [](Repository& repo) { repo.beginBatch(); });
+        }
+    };
+    openBatch();
+    
+    int failures = 0;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(' ') == std::string::npos) {
+            continue;
+        }
+        
+        std::string request = qualifyRequest(line, repoName);
+        size_t payloadSize;
+        std::string payload;
+        RequestReply reply;
+        bool shutdown = false;
+        if (!RequestHandler::getPayloadSize(request, payloadSize)) {
+            reply.ok = false;
+            reply.body = "malformed request";
+        } else {
+            if (!readPayload(payloadSize, payload)) {
+                std::cerr << "error: content cut short" << std::endl;
+                failures++;
+                break;
+            }
+            reply = handler.handle(request, payload, shutdown);
+        }
+        
+        if (!reply.ok) {
+            failures++;
+        } else {
+            openBatch();
+        }
+        std::cout << RequestHandler::formatReply(reply) << std::flush;
+        if (shutdown) {
+            break;
+        }
+    }
+    
+    if (batchOpen) {
+        bool flushed = false;
+        host.withWriter(repoName, [&](Repository& repo) { flushed = repo.endBatch(); });
+        if (!flushed) {
+            std::cerr << "error: could not flush the batch's commits" << std::endl;
+            failures++;
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 2;
+    }
+    
+    std::string command = argv[1];
+    std::string repoName;
+    std::string message;
+    std::vector<std::string> arguments;
+    for (int i = 2; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--repo" && i + 1 < argc) {
+            repoName = argv[++i];
+        } else if (argument == "-m" && i + 1 < argc) {
+            message = argv[++i];
+        } else {
+            arguments.push_back(argument);
+        }
+    }
+    
+    RepositoryHost host("repos");
+    if (command == "batch") {
+        return runBatch(host, repoName);
+    }
+    if (repoName.empty()) {
+        printUsage();
+        return 2;
+    }
+    
+    // Build the equivalent request
+    std::string request;
+    std::string payload;
+    if (command == "init" && arguments.empty()) {
+        request = "INIT " + repoName;
+    } else if (command == "add" && (arguments.size() == 1 || arguments.size() == 2)) {
+        if (!readSource(arguments.size() == 2 ? arguments[1] : arguments[0], payload)) {
+            std::cerr << "error: cannot read " << (arguments.size() == 2 ? arguments[1] : arguments[0]) << std::endl;
+            return 1;
+        }
+        request = "ADD " + repoName + " " + arguments[0] + " " + std::to_string(payload.size());
+    } else if (command == "commit" && !message.empty() && arguments.empty()) {
+        request = "COMMIT " + repoName + " " + message;
+    } else if ((command == "status" || command == "files" || command == "log") && arguments.empty()) {
+        request = (command == "status" ? "STATUS " : command == "files" ? "FILES " : "LOG ") + repoName;
+    } else if (command == "cat" && (arguments.size() == 1 || arguments.size() == 2)) {
+        request = "CAT " + repoName + " " + arguments[0] + (arguments.size() == 2 ? " " + arguments[1] : "");
+    } else if (command == "diff" && arguments.size() == 3) {
+        request = "DIFF " + repoName + " " + arguments[0] + " " + arguments[1] + " " + arguments[2];
+    } else if (command == "revert" && arguments.size() == 1) {
+        request = "REVERT " + repoName + " " + arguments[0];
+    } else if (command == "branch" && arguments.empty()) {
+        request = "BRANCHES " + repoName;
+    } else if (command == "branch" && arguments.size() <= 2) {
+        request = "BRANCH " + repoName + " " + arguments[0] + (arguments.size() == 2 ? " " + arguments[1] : "");
+    } else if (command == "switch" && arguments.size() == 1) {
+        request = "SWITCH " + repoName + " " + arguments[0];
+    } else if (command == "merge" && arguments.size() == 1) {
+        request = "MERGE " + repoName + " " + arguments[0];
+    } else if ((command == "search" || command == "grep") && arguments.size() == 1 &&
+               arguments[0].find('\n') == std::string::npos) {
+        request = (command == "search" ? "SEARCH " : "GREP ") + repoName + " " + arguments[0];
+    } else if (command == "repack" && arguments.empty()) {
+        request = "REPACK " + repoName;
+    } else {
+        printUsage();
+        return 2;
+    }
+    
+    RequestHandler handler(host);
+    bool shutdown;
+    RequestReply reply = handler.handle(request, payload, shutdown);
+    if (!reply.ok) {
+        std::cerr << "error: " << reply.body << std::endl;
+        return 1;
+    }
+    if (command == "init") {
+        registerRepository(repoName);
+    }
+    std::cout << reply.body;
+    if (!reply.body.empty() && reply.body.back() != '\n') {
+        std::cout << std::endl;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <string>
+#include "vcs/RepositoryHost.h"
+#include "vcs/RepositoryServer.h"
+#include "vcs/Trace.h"
+
+// Headless server: keeps every repository under repos/ open and serves
+// requests on a local socket (see vcs/RepositoryServer.h for the protocol).
+// With --trace, every timed operation is captured and written as a Chrome
+// trace when the server stops; that needs a build with MINIVCS_TRACE.
+int main(int argc, char* argv[]) {
+    std::string socketPath = "minivcs.sock";
+    std::string tracePath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else {
+            socketPath = arg;
+        }
+    }
+    if (!tracePath.empty()) {
+        Trace::setCaptureEvents(true);
+    }
+    
+    RepositoryHost host("repos");
+    RepositoryServer server(host);
+    if (!server.listen(socketPath)) {
+        std::cerr << "Cannot listen on " << socketPath << std::endl;
+        return 1;
+    }
+    
+    std::cout << "MiniVCS server listening on " << socketPath << std::endl;
+    server.run();
+    
+    // Keep uncommitted edits for the next session
+    host.saveAll();
+    if (!tracePath.empty() && !Trace::writeChromeTrace(tracePath)) {
+        std::cerr << "Cannot write " << tracePath << std::endl;
+    }
+    std::cout << "MiniVCS server stopped" << std::endl;
+    return 0;
+}
\ No newline at end of file
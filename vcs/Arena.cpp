@@ -0,0 +1,107 @@
+#include "Arena.h"
+#include <cstring>
+#include <cstdint>
+#include <new>
+
+Arena::Arena()
+    : blocks(nullptr), cursor(nullptr), limit(nullptr), nextBlockSize(INITIAL_BLOCK_SIZE),
+      bytesUsed(0), bytesReserved(0) {
+}
+
+Arena::~Arena() {
+    release();
+}
+
+std::string_view Arena::copyString(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* copy = static_cast<char*>(allocate(text.size(), 1));
+    memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
+
+void Arena::adopt(Arena& other) {
+    if (&other == this || !other.blocks) {
+        return;
+    }
+    
+    // Other's blocks go behind ours, so new allocations keep using our newest block
+    Block* last = other.blocks;
+    while (last->next) {
+        last = last->next;
+    }
+    if (blocks) {
+        last->next = blocks->next;
+        blocks->next = other.blocks;
+    } else {
+        last->next = nullptr;
+        blocks = other.blocks;
+        cursor = other.cursor;
+        limit = other.limit;
+    }
+    bytesUsed += other.bytesUsed;
+    bytesReserved += other.bytesReserved;
+    
+    other.blocks = nullptr;
+    other.cursor = nullptr;
+    other.limit = nullptr;
+    other.nextBlockSize = INITIAL_BLOCK_SIZE;
+    other.bytesUsed = 0;
+    other.bytesReserved = 0;
+}
+
+void Arena::release() {
+    while (blocks) {
+        Block* next = blocks->next;
+        ::operator delete(blocks);
+        blocks = next;
+    }
+    cursor = nullptr;
+    limit = nullptr;
+    nextBlockSize = INITIAL_BLOCK_SIZE;
+    bytesUsed = 0;
+    bytesReserved = 0;
+}
+
+size_t Arena::getBytesUsed() const {
+    return bytesUsed;
+}
+
+size_t Arena::getBytesReserved() const {
+    return bytesReserved;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    if (!cursor || aligned + bytes > reinterpret_cast<uintptr_t>(limit)) {
+        addBlock(bytes + alignment);
+        aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    }
+    cursor = reinterpret_cast<char*>(aligned + bytes);
+    bytesUsed += bytes;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::do_deallocate(void*, size_t, size_t) {
+    // Freed with the whole arena
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void Arena::addBlock(size_t minimumSize) {
+    // Blocks double up to a cap; an oversized request gets a block to itself
+    size_t size = (minimumSize > nextBlockSize) ? minimumSize : nextBlockSize;
+    Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+    block->size = size;
+    block->next = blocks;
+    blocks = block;
+    cursor = reinterpret_cast<char*>(block + 1);
+    limit = cursor + size;
+    bytesReserved += size;
+    if (nextBlockSize < MAX_BLOCK_SIZE) {
+        nextBlockSize *= 2;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <cstddef>
+
+// Monotonic allocator for a repository's loaded history. Allocations are
+// carved from a few large blocks and never freed one by one; release()
+// hands every block back at once. Anything placed in an arena must either
+// be trivially destructible or keep its own memory in the same arena, as
+// destructors are not run. Not thread-safe: parallel loaders fill arenas of
+// their own and adopt() them into the repository's afterwards.
+class Arena : public std::pmr::memory_resource {
+private:
+    struct Block {
+        Block* next;
+        size_t size;    // Usable bytes after the header
+    };
+    
+    Block* blocks;          // Most recent first
+    char* cursor;           // Free space in the newest block
+    char* limit;
+    size_t nextBlockSize;
+    size_t bytesUsed;
+    size_t bytesReserved;
+    
+    static const size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+    static const size_t MAX_BLOCK_SIZE = 4 * 1024 * 1024;
+
+public:
+    Arena();
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+    
+    // Copy of the characters that lives as long as the arena
+    std::string_view copyString(std::string_view text);
+    
+    // Take over other's blocks; other is left empty
+    void adopt(Arena& other);
+    void release();
+    
+    size_t getBytesUsed() const;
+    size_t getBytesReserved() const;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    void addBlock(size_t minimumSize);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+// Little-endian encode/decode helpers shared by the binary on-disk formats
+
+inline void appendU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+inline void appendU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+inline void putU32(char* dest, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        dest[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+inline uint32_t readU32(const char* src) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t readU64(const char* src) {
+    return static_cast<uint64_t>(readU32(src)) | (static_cast<uint64_t>(readU32(src + 4)) << 32);
+}
+
+#endif
\ No newline at end of file
@@ -1,41 +1,98 @@
 #include "Commit.h"
+#include "ObjectStore.h"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
-Commit::Commit(int id, const std::string& msg) 
-    : versionId(id), message(msg), prev(nullptr), next(nullptr) {
-    timestamp = getCurrentTime();
+Commit::Commit(Arena& owner, TreePool& pool, int id, std::string_view msg, ObjectStore* store) 
+    : versionId(id), message(owner.copyString(msg)), objectStore(store),
+      trees(&pool), prev(nullptr), parents(nullptr), parentCount(0), generation(1), listingDepth(0) {
+    timestamp = owner.copyString(getCurrentTime());
 }
 
-Commit::~Commit() {
-    // Destructor - cleanup handled by Repository
+Commit::Commit(Arena& owner, TreePool& pool, int id, std::string_view msg, std::string_view time,
+               ObjectStore* store)
+    : versionId(id), message(owner.copyString(msg)), timestamp(owner.copyString(time)),
+      objectStore(store), trees(&pool), prev(nullptr), parents(nullptr), parentCount(0), generation(1),
+      listingDepth(0) {
+}
+
+void Commit::setParents(Arena& owner, Commit* const* newParents, uint32_t count) {
+    parents = nullptr;
+    if (count > 0) {
+        parents = static_cast<Commit**>(owner.allocate(count * sizeof(Commit*), alignof(Commit*)));
+        std::copy(newParents, newParents + count, parents);
+    }
+    parentCount = count;
+    prev = count > 0 ? parents[0] : nullptr;
+    
+    generation = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        generation = std::max(generation, parents[i]->generation + 1);
+    }
 }
 
 void Commit::addFile(const std::string& filename, const std::string& content) {
-    files[filename] = content;
+    if (!objectStore) {
+        return;
+    }
+    addBlob(filename, objectStore->writeBlob(content), content.length());
+}
+
+void Commit::addBlob(std::string_view filename, std::string_view blobId, size_t size) {
+    std::vector<TreeEdit> edits(1);
+    edits[0].path = filename;
+    edits[0].file.blobId = blobId;
+    edits[0].file.size = size;
+    edits[0].remove = false;
+    files = trees->apply(files, edits);
 }
 
 std::string Commit::getFile(const std::string& filename) const {
-    auto it = files.find(filename);
-    if (it != files.end()) {
-        return it->second;
+    const FileEntry* entry = files.find(filename);
+    std::string content;
+    if (entry && objectStore) {
+        objectStore->readBlob(std::string(entry->blobId), content);
     }
-    return "";
+    return content;
+}
+
+std::shared_ptr<const std::string> Commit::getFileBuffer(const std::string& filename) const {
+    const FileEntry* entry = files.find(filename);
+    if (entry && objectStore) {
+        return objectStore->readBlobBuffer(std::string(entry->blobId));
+    }
+    return nullptr;
+}
+
+size_t Commit::getFileSize(const std::string& filename) const {
+    const FileEntry* entry = files.find(filename);
+    return entry ? entry->size : 0;
+}
+
+std::string Commit::getBlobId(const std::string& filename) const {
+    const FileEntry* entry = files.find(filename);
+    return entry ? std::string(entry->blobId) : "";
 }
 
 bool Commit::hasFile(const std::string& filename) const {
-    return files.find(filename) != files.end();
+    return files.find(filename) != nullptr;
 }
 
 std::string Commit::getTimestamp() const {
-    return timestamp;
+    return std::string(timestamp);
 }
 
 std::string Commit::getCurrentTime() {
     time_t now = time(0);
-    tm* timeinfo = localtime(&now);
+    tm timeinfo;
+#ifdef _WIN32
+    localtime_s(&timeinfo, &now);
+#else
+    localtime_r(&now, &timeinfo);
+#endif
     
     std::stringstream ss;
-    ss << std::put_time(timeinfo, "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&timeinfo, "%Y-%m-%d %H:%M:%S");
     return ss.str();
 }
\ No newline at end of file
@@ -1,24 +1,48 @@
 #ifndef COMMIT_H
 #define COMMIT_H
 
+#include "Arena.h"
+#include "TreePool.h"
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <memory>
 #include <ctime>
 
+class ObjectStore;
+
+// Commits live in their repository's Arena (see Arena::create) and are
+// never deleted one by one: the message lives in the same arena and the
+// file tree in the repository's TreePool, so the whole history is freed
+// with those two.
 class Commit {
 public:
     int versionId;
-    std::string message;
-    std::string timestamp;
-    std::unordered_map<std::string, std::string> files; // filename -> file content
-    Commit* prev;
-    Commit* next;
+    std::string_view message;
+    std::string_view timestamp;
+    FileTree files;             // filename -> blob reference, shared with other commits
+    ObjectStore* objectStore;   // Where file contents are stored
+    TreePool* trees;            // Builds and owns files
+    Commit* prev;               // First parent, or null for a root commit
+    Commit** parents;           // Every parent, first parent first; in the owning arena
+    uint32_t parentCount;       // More than one for a merge
+    uint32_t generation;        // 1 for a root commit, else one more than its highest parent
+    uint32_t listingDepth;      // Saved commit files back to one listing every path (see CommitWriter)
+    
+    Commit(Arena& owner, TreePool& pool, int id, std::string_view msg, ObjectStore* store = nullptr);
+    // For commits read back from disk; does not look at the clock
+    Commit(Arena& owner, TreePool& pool, int id, std::string_view msg, std::string_view time,
+           ObjectStore* store);
     
-    Commit(int id, const std::string& msg);
-    ~Commit();
+    // Replace the parents; the list is copied into owner. The parents'
+    // generations must already be set.
+    void setParents(Arena& owner, Commit* const* newParents, uint32_t count);
     
     void addFile(const std::string& filename, const std::string& content);
+    void addBlob(std::string_view filename, std::string_view blobId, size_t size);
     std::string getFile(const std::string& filename) const;
+    std::shared_ptr<const std::string> getFileBuffer(const std::string& filename) const;
+    size_t getFileSize(const std::string& filename) const;
+    std::string getBlobId(const std::string& filename) const;
     bool hasFile(const std::string& filename) const;
     std::string getTimestamp() const;
     
@@ -0,0 +1,252 @@
+#include "CommitFormat.h"
+#include "BinaryIO.h"
+
+static const char COMMIT_MAGIC[4] = { 'M', 'V', 'C', 'B' };
+static const size_t HEADER_SIZE_V1 = 32;
+static const size_t HEADER_SIZE_V2 = 40;
+static const size_t HEADER_SIZE = 48;
+static const size_t ENTRY_SIZE = 24;
+
+static size_t headerSizeFor(uint32_t formatVersion) {
+    return formatVersion >= 3 ? HEADER_SIZE : formatVersion == 2 ? HEADER_SIZE_V2 : HEADER_SIZE_V1;
+}
+
+static void appendEntry(std::string& table, std::string& payload, std::string_view path, const FileEntry& file) {
+    appendU32(table, static_cast<uint32_t>(payload.size()));
+    appendU32(table, static_cast<uint32_t>(path.size()));
+    payload += path;
+    appendU32(table, static_cast<uint32_t>(payload.size()));
+    appendU32(table, static_cast<uint32_t>(file.blobId.size()));
+    payload += file.blobId;
+    appendU64(table, file.size);
+}
+
+std::string CommitWriter::encode(const Commit* commit, uint32_t* listingDepth) {
+    // Only the differences from a saved first parent, unless the chain
+    // back to a full listing is long enough
+    const Commit* base = commit->prev;
+    bool partial = base && base->versionId > 0 && base->listingDepth + 1 < COMMIT_LISTING_INTERVAL;
+    std::vector<std::pair<std::string, FileEntry>> changes;
+    if (partial) {
+        FileTree::compare(base->files, commit->files,
+                          [&](std::string_view path, const FileEntry*, const FileEntry* after) {
+            FileEntry removed = { std::string_view(), 0 };
+            changes.emplace_back(std::string(path), after ? *after : removed);
+        });
+        // Listing most of the tree anyway: list all of it
+        partial = changes.size() * 2 <= commit->files.size();
+    }
+    uint32_t depth = partial ? base->listingDepth + 1 : 0;
+    if (listingDepth) {
+        *listingDepth = depth;
+    }
+    
+    std::string table;
+    std::string payload;
+    table.reserve((partial ? changes.size() : commit->files.size()) * ENTRY_SIZE);
+    
+    uint32_t messageOffset = static_cast<uint32_t>(payload.size());
+    payload += commit->message;
+    uint32_t timestampOffset = static_cast<uint32_t>(payload.size());
+    payload += commit->timestamp;
+    uint32_t parentsOffset = static_cast<uint32_t>(payload.size());
+    for (uint32_t i = 0; i < commit->parentCount; i++) {
+        appendU32(payload, static_cast<uint32_t>(commit->parents[i]->versionId));
+    }
+    
+    if (partial) {
+        for (const auto& change : changes) {
+            appendEntry(table, payload, change.first, change.second);
+        }
+    } else {
+        for (const auto& fileEntry : commit->files) {
+            appendEntry(table, payload, fileEntry.first, fileEntry.second);
+        }
+    }
+    
+    std::string out;
+    out.reserve(HEADER_SIZE + table.size() + payload.size());
+    out.append(COMMIT_MAGIC, 4);
+    appendU32(out, COMMIT_FORMAT_VERSION);
+    appendU32(out, static_cast<uint32_t>(commit->versionId));
+    appendU32(out, static_cast<uint32_t>(table.size() / ENTRY_SIZE));
+    appendU32(out, messageOffset);
+    appendU32(out, static_cast<uint32_t>(commit->message.size()));
+    appendU32(out, timestampOffset);
+    appendU32(out, static_cast<uint32_t>(commit->timestamp.size()));
+    appendU32(out, parentsOffset);
+    appendU32(out, commit->parentCount);
+    appendU32(out, partial ? static_cast<uint32_t>(base->versionId) : 0);
+    appendU32(out, depth);
+    out += table;
+    out += payload;
+    return out;
+}
+
+uint32_t CommitWriter::getMessageOffset(const std::string& encoded) {
+    return getMessageOffset(encoded.data());
+}
+
+uint32_t CommitWriter::getMessageOffset(const char* record) {
+    size_t headerSize = headerSizeFor(readU32(record + 4));
+    uint32_t fileCount = readU32(record + 12);
+    return static_cast<uint32_t>(headerSize + fileCount * ENTRY_SIZE) + readU32(record + 16);
+}
+
+CommitReader::CommitReader()
+    : buffer(nullptr), bufferSize(0), headerLength(0), payload(nullptr), payloadSize(0),
+      formatVersion(0), versionId(0), fileCount(0), parentCount(0), parentIds(nullptr), baseId(0),
+      listingDepth(0) {
+}
+
+bool CommitReader::open(const std::string& path) {
+    if (!file.open(path)) {
+        return false;
+    }
+    return parse(file.data(), file.size());
+}
+
+bool CommitReader::parse(const char* data, size_t size) {
+    if (!isBinaryCommit(data, size)) {
+        return false;
+    }
+    
+    formatVersion = readU32(data + 4);
+    if (formatVersion > COMMIT_FORMAT_VERSION) {
+        return false; // Written by a newer version
+    }
+    
+    size_t headerSize = headerSizeFor(formatVersion);
+    if (size < headerSize) {
+        return false;
+    }
+    buffer = data;
+    bufferSize = size;
+    headerLength = headerSize;
+    versionId = static_cast<int>(readU32(data + 8));
+    fileCount = readU32(data + 12);
+    
+    uint64_t tableSize = static_cast<uint64_t>(fileCount) * ENTRY_SIZE;
+    if (headerSize + tableSize > size) {
+        return false;
+    }
+    payload = data + headerSize + tableSize;
+    payloadSize = size - headerSize - static_cast<size_t>(tableSize);
+    
+    uint32_t messageOffset = readU32(data + 16);
+    uint32_t messageLength = readU32(data + 20);
+    uint32_t timestampOffset = readU32(data + 24);
+    uint32_t timestampLength = readU32(data + 28);
+    if (!validRange(messageOffset, messageLength) || !validRange(timestampOffset, timestampLength)) {
+        return false;
+    }
+    message = std::string_view(payload + messageOffset, messageLength);
+    timestamp = std::string_view(payload + timestampOffset, timestampLength);
+    
+    parentCount = 0;
+    parentIds = nullptr;
+    if (formatVersion >= 2) {
+        uint32_t parentsOffset = readU32(data + 32);
+        uint32_t count = readU32(data + 36);
+        if (!validRange(parentsOffset, static_cast<uint64_t>(count) * 4)) {
+            return false;
+        }
+        parentCount = count;
+        parentIds = payload + parentsOffset;
+    }
+    baseId = 0;
+    listingDepth = 0;
+    if (formatVersion >= 3) {
+        baseId = static_cast<int>(readU32(data + 40));
+        listingDepth = readU32(data + 44);
+        if (baseId < 0) {
+            return false;
+        }
+    }
+    
+    // Check every table entry up front so getFile() never reads out of bounds
+    const char* entry = data + headerSize;
+    for (uint32_t i = 0; i < fileCount; i++, entry += ENTRY_SIZE) {
+        if (!validRange(readU32(entry), readU32(entry + 4)) ||
+            !validRange(readU32(entry + 8), readU32(entry + 12))) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+int CommitReader::getVersionId() const {
+    return versionId;
+}
+
+uint32_t CommitReader::getFormatVersion() const {
+    return formatVersion;
+}
+
+std::string_view CommitReader::getMessage() const {
+    return message;
+}
+
+std::string_view CommitReader::getTimestamp() const {
+    return timestamp;
+}
+
+uint32_t CommitReader::getFileCount() const {
+    return fileCount;
+}
+
+CommitFileView CommitReader::getFile(uint32_t index) const {
+    const char* entry = buffer + headerLength + static_cast<size_t>(index) * ENTRY_SIZE;
+    CommitFileView view;
+    view.filename = std::string_view(payload + readU32(entry), readU32(entry + 4));
+    view.blobId = std::string_view(payload + readU32(entry + 8), readU32(entry + 12));
+    view.size = readU64(entry + 16);
+    return view;
+}
+
+bool CommitReader::hasParents() const {
+    return formatVersion >= 2;
+}
+
+uint32_t CommitReader::getParentCount() const {
+    return parentCount;
+}
+
+int CommitReader::getParentId(uint32_t index) const {
+    return static_cast<int>(readU32(parentIds + static_cast<size_t>(index) * 4));
+}
+
+int CommitReader::getBaseId() const {
+    return baseId;
+}
+
+Commit* CommitReader::toCommit(ObjectStore* store, Arena& arena, TreePool& trees,
+                               const FileTree& similar, const Commit* base) const {
+    if (baseId != 0 && (!base || base->versionId != baseId)) {
+        return nullptr;
+    }
+    Commit* commit = arena.create<Commit>(arena, trees, versionId, message, timestamp, store);
+    std::vector<TreeEdit> files(fileCount);
+    for (uint32_t i = 0; i < fileCount; i++) {
+        CommitFileView view = getFile(i);
+        files[i].path = view.filename;
+        files[i].file.blobId = view.blobId;
+        files[i].file.size = static_cast<size_t>(view.size);
+        files[i].remove = view.blobId.empty();
+    }
+    
+    // Directories another commit already has come back as the same nodes
+    commit->files = (baseId != 0) ? trees.apply(base->files, files) : trees.build(files, similar);
+    commit->listingDepth = listingDepth;
+    return commit;
+}
+
+bool CommitReader::isBinaryCommit(const char* data, size_t size) {
+    return size >= HEADER_SIZE_V1 && data[0] == COMMIT_MAGIC[0] && data[1] == COMMIT_MAGIC[1] &&
+           data[2] == COMMIT_MAGIC[2] && data[3] == COMMIT_MAGIC[3];
+}
+
+bool CommitReader::validRange(uint32_t offset, uint64_t length) const {
+    return static_cast<uint64_t>(offset) + length <= payloadSize;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef COMMITFORMAT_H
+#define COMMITFORMAT_H
+
+#include "Commit.h"
+#include "MappedFile.h"
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Binary commit file layout (all integers little-endian):
+//
+//   Header   magic "MVCB", format version, commit id, file count,
+//            message offset/length, timestamp offset/length,
+//            parent ids offset/count (version 2), base id and
+//            listing depth (version 3)
+//   Table    one fixed-size entry per file: name offset/length,
+//            blob id offset/length, content size
+//   Payload  message, timestamp, parent ids, names and blob ids back to back
+//
+// Offsets are relative to the start of the payload, so a reader only has
+// to validate them once and can then hand out views into the buffer.
+// Version 1 records carry no parents; the commit index has the first one.
+//
+// A record with a base id lists only the files that differ from the base
+// (the first parent): changed and added files, and removed ones with an
+// empty blob id. Saving a commit then costs its edits, not its tree. Every
+// COMMIT_LISTING_INTERVAL commits along a first-parent chain, and whenever
+// most of the tree changed, the record lists every file instead (base id
+// 0), so no record depends on a long chain of others.
+
+const uint32_t COMMIT_FORMAT_VERSION = 3;
+const uint32_t COMMIT_LISTING_INTERVAL = 32;
+
+struct CommitFileView {
+    std::string_view filename;
+    std::string_view blobId;
+    uint64_t size;
+};
+
+class CommitWriter {
+public:
+    // listingDepth, if given, receives the depth to record in the commit
+    static std::string encode(const Commit* commit, uint32_t* listingDepth = nullptr);
+    
+    // Byte offset of the message within an encoded commit
+    static uint32_t getMessageOffset(const std::string& encoded);
+    static uint32_t getMessageOffset(const char* record);
+};
+
+class CommitReader {
+private:
+    MappedFile file;
+    const char* buffer;
+    size_t bufferSize;
+    size_t headerLength;        // Depends on the format version
+    const char* payload;
+    size_t payloadSize;
+    uint32_t formatVersion;
+    int versionId;
+    uint32_t fileCount;
+    uint32_t parentCount;
+    const char* parentIds;
+    int baseId;                 // 0 if every file is listed
+    uint32_t listingDepth;
+    std::string_view message;
+    std::string_view timestamp;
+    
+public:
+    CommitReader();
+    
+    // Map a commit file from disk, or parse bytes owned by the caller
+    bool open(const std::string& path);
+    bool parse(const char* data, size_t size);
+    
+    int getVersionId() const;
+    uint32_t getFormatVersion() const;
+    std::string_view getMessage() const;
+    std::string_view getTimestamp() const;
+    uint32_t getFileCount() const;
+    CommitFileView getFile(uint32_t index) const;
+    
+    // False for version 1 records, which do not list parents
+    bool hasParents() const;
+    uint32_t getParentCount() const;
+    int getParentId(uint32_t index) const;
+    
+    // The commit the listed files are changes to, or 0 if all are listed
+    int getBaseId() const;
+    
+    // Build a Commit from the parsed data, allocated in arena. similar is a
+    // tree likely to share directories with this commit's (see TreePool::build).
+    // A record with a base needs that commit as base; null if it is missing.
+    // Parents are left unlinked; they are only known by id here.
+    Commit* toCommit(ObjectStore* store, Arena& arena, TreePool& trees, const FileTree& similar,
+                     const Commit* base = nullptr) const;
+    
+    static bool isBinaryCommit(const char* data, size_t size);
+    
+private:
+    bool validRange(uint32_t offset, uint64_t length) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "CommitGraph.h"
+#include "BinaryIO.h"
+#include "MappedFile.h"
+#include "FileSync.h"
+#include <fstream>
+#include <queue>
+#include <algorithm>
+#include <sys/stat.h>
+
+// File layout: magic "MVCG", format version, then per commit: version id,
+// generation, timestamp, parent count and the parents' version ids
+static const char GRAPH_MAGIC[4] = { 'M', 'V', 'C', 'G' };
+static const uint32_t GRAPH_VERSION = 1;
+static const size_t GRAPH_HEADER_SIZE = 8;
+static const size_t GRAPH_RECORD_SIZE = 20;     // Without the parents
+
+CommitGraph::CommitGraph() : savedCount(0), maxVersionId(0), loaded(false) {
+    parentStart.push_back(0);
+}
+
+void CommitGraph::setGraphPath(const std::string& path) {
+    graphPath = path;
+    maxVersionId = 0;
+    clear();
+}
+
+void CommitGraph::setMaxVersionId(int versionId) {
+    maxVersionId = versionId;
+}
+
+int CommitGraph::getMaxVersionId() const {
+    return maxVersionId;
+}
+
+bool CommitGraph::load() {
+    clear();
+    
+    MappedFile file;
+    if (!file.open(graphPath)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    if (size < GRAPH_HEADER_SIZE || data[0] != GRAPH_MAGIC[0] || data[1] != GRAPH_MAGIC[1] ||
+        data[2] != GRAPH_MAGIC[2] || data[3] != GRAPH_MAGIC[3] || readU32(data + 4) > GRAPH_VERSION) {
+        return false;
+    }
+    
+    size_t pos = GRAPH_HEADER_SIZE;
+    while (size - pos >= GRAPH_RECORD_SIZE) {
+        uint32_t parentCount = readU32(data + pos + 16);
+        if ((size - pos - GRAPH_RECORD_SIZE) / 4 < parentCount) {
+            break;
+        }
+        int versionId = static_cast<int>(readU32(data + pos));
+        if (versionId < 0 || versionId > maxVersionId || positionOf(versionId) >= 0) {
+            clear();
+            return false;
+        }
+        
+        // Parents are always recorded before their children
+        for (uint32_t i = 0; i < parentCount; i++) {
+            int32_t parent = positionOf(static_cast<int>(readU32(data + pos + GRAPH_RECORD_SIZE + i * 4)));
+            if (parent >= 0) {
+                parentList.push_back(static_cast<uint32_t>(parent));
+            }
+        }
+        if (static_cast<size_t>(versionId) >= positions.size()) {
+            positions.resize(static_cast<size_t>(versionId) + 1, -1);
+        }
+        positions[versionId] = static_cast<int32_t>(versionIds.size());
+        versionIds.push_back(versionId);
+        generations.push_back(readU32(data + pos + 4));
+        timestamps.push_back(static_cast<int64_t>(readU64(data + pos + 8)));
+        parentStart.push_back(static_cast<uint32_t>(parentList.size()));
+        pos += GRAPH_RECORD_SIZE + static_cast<size_t>(parentCount) * 4;
+    }
+    
+    savedCount = versionIds.size();
+    loaded = true;
+    
+    // Drop a torn tail (crash mid-append) so later appends stay aligned
+    if (pos != size) {
+        file.close();
+        return rewrite();
+    }
+    return true;
+}
+
+bool CommitGraph::exists() const {
+    struct stat info;
+    return stat(graphPath.c_str(), &info) == 0;
+}
+
+void CommitGraph::clear() {
+    versionIds.clear();
+    generations.clear();
+    timestamps.clear();
+    parentStart.assign(1, 0);
+    parentList.clear();
+    positions.clear();
+    savedCount = 0;
+    loaded = false;
+}
+
+bool CommitGraph::add(int versionId, const std::vector<int>& parentIds, int64_t timestamp) {
+    if (versionId < 0 || versionId > maxVersionId || positionOf(versionId) >= 0) {
+        return false;
+    }
+    
+    uint32_t generation = 1;
+    for (int parentId : parentIds) {
+        int32_t parent = positionOf(parentId);
+        if (parent >= 0) {
+            parentList.push_back(static_cast<uint32_t>(parent));
+            generation = std::max(generation, generations[parent] + 1);
+        }
+    }
+    if (static_cast<size_t>(versionId) >= positions.size()) {
+        positions.resize(static_cast<size_t>(versionId) + 1, -1);
+    }
+    positions[versionId] = static_cast<int32_t>(versionIds.size());
+    versionIds.push_back(versionId);
+    generations.push_back(generation);
+    timestamps.push_back(timestamp);
+    parentStart.push_back(static_cast<uint32_t>(parentList.size()));
+    return true;
+}
+
+bool CommitGraph::save() {
+    if (savedCount == versionIds.size()) {
+        return true;
+    }
+    if (!loaded || !exists()) {
+        return rewrite();
+    }
+    
+    std::string records;
+    for (size_t position = savedCount; position < versionIds.size(); position++) {
+        encodeRecord(records, position);
+    }
+    std::ofstream file(graphPath, std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(records.data(), records.size());
+    if (!file.good()) {
+        return false;
+    }
+    savedCount = versionIds.size();
+    return true;
+}
+
+bool CommitGraph::rewrite() {
+    std::string out;
+    out.append(GRAPH_MAGIC, 4);
+    appendU32(out, GRAPH_VERSION);
+    for (size_t position = 0; position < versionIds.size(); position++) {
+        encodeRecord(out, position);
+    }
+    
+    // Rebuilt from the commits if lost, so it is not synced
+    if (!FileSync::replaceFile(graphPath, out, false)) {
+        return false;
+    }
+    savedCount = versionIds.size();
+    loaded = true;
+    return true;
+}
+
+size_t CommitGraph::size() const {
+    return versionIds.size();
+}
+
+bool CommitGraph::contains(int versionId) const {
+    return positionOf(versionId) >= 0;
+}
+
+uint32_t CommitGraph::getGeneration(int versionId) const {
+    int32_t position = positionOf(versionId);
+    return position >= 0 ? generations[position] : 0;
+}
+
+int64_t CommitGraph::getTimestamp(int versionId) const {
+    int32_t position = positionOf(versionId);
+    return position >= 0 ? timestamps[position] : 0;
+}
+
+std::vector<int> CommitGraph::getParents(int versionId) const {
+    std::vector<int> parents;
+    int32_t position = positionOf(versionId);
+    if (position >= 0) {
+        for (uint32_t i = parentStart[position]; i < parentStart[position + 1]; i++) {
+            parents.push_back(versionIds[parentList[i]]);
+        }
+    }
+    return parents;
+}
+
+bool CommitGraph::isAncestor(int ancestorId, int descendantId) const {
+    int32_t target = positionOf(ancestorId);
+    int32_t start = positionOf(descendantId);
+    if (target < 0 || start < 0) {
+        return false;
+    }
+    
+    // Anything at or below the target's generation that is not the target
+    // cannot lead to it
+    uint32_t targetGeneration = generations[target];
+    std::vector<char> seen(versionIds.size(), 0);
+    std::vector<uint32_t> pending(1, static_cast<uint32_t>(start));
+    seen[start] = 1;
+    while (!pending.empty()) {
+        uint32_t position = pending.back();
+        pending.pop_back();
+        if (position == static_cast<uint32_t>(target)) {
+            return true;
+        }
+        if (generations[position] <= targetGeneration) {
+            continue;
+        }
+        for (uint32_t i = parentStart[position]; i < parentStart[position + 1]; i++) {
+            uint32_t parent = parentList[i];
+            if (!seen[parent]) {
+                seen[parent] = 1;
+                pending.push_back(parent);
+            }
+        }
+    }
+    return false;
+}
+
+int CommitGraph::findMergeBase(int a, int b) const {
+    int32_t first = positionOf(a);
+    int32_t second = positionOf(b);
+    if (first < 0 || second < 0) {
+        return -1;
+    }
+    if (first == second) {
+        return a;
+    }
+    
+    const char FROM_A = 1;
+    const char FROM_B = 2;
+    auto older = [this](uint32_t x, uint32_t y) {
+        return generations[x] < generations[y] ||
+               (generations[x] == generations[y] && versionIds[x] < versionIds[y]);
+    };
+    std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(older)> pending(older);
+    std::vector<char> reached(versionIds.size(), 0);
+    reached[first] = FROM_A;
+    reached[second] = FROM_B;
+    pending.push(static_cast<uint32_t>(first));
+    pending.push(static_cast<uint32_t>(second));
+    
+    while (!pending.empty()) {
+        uint32_t position = pending.top();
+        pending.pop();
+        char from = reached[position];
+        if (from == (FROM_A | FROM_B)) {
+            return versionIds[position];
+        }
+        for (uint32_t i = parentStart[position]; i < parentStart[position + 1]; i++) {
+            uint32_t parent = parentList[i];
+            if ((reached[parent] | from) != reached[parent]) {
+                if (reached[parent] == 0) {
+                    pending.push(parent);
+                }
+                reached[parent] |= from;
+            }
+        }
+    }
+    return -1;
+}
+
+int32_t CommitGraph::positionOf(int versionId) const {
+    if (versionId < 0 || static_cast<size_t>(versionId) >= positions.size()) {
+        return -1;
+    }
+    return positions[versionId];
+}
+
+void CommitGraph::encodeRecord(std::string& out, size_t position) const {
+    appendU32(out, static_cast<uint32_t>(versionIds[position]));
+    appendU32(out, generations[position]);
+    appendU64(out, static_cast<uint64_t>(timestamps[position]));
+    appendU32(out, parentStart[position + 1] - parentStart[position]);
+    for (uint32_t i = parentStart[position]; i < parentStart[position + 1]; i++) {
+        appendU32(out, static_cast<uint32_t>(versionIds[parentList[i]]));
+    }
+}
\ No newline at end of file
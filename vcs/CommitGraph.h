@@ -0,0 +1,68 @@
+#ifndef COMMITGRAPH_H
+#define COMMITGRAPH_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Shape of the history in data/commits/graph.bin: for every saved commit
+// its parents, generation number and timestamp. In memory these are flat
+// arrays indexed by position, with parents as positions too, so ancestry
+// queries never touch a commit file or a Commit.
+//
+// A commit's generation is 1 if it has no saved parent, else one more than
+// its highest parent's. An ancestor always has a lower generation than its
+// descendants, which lets walks stop at the generation they are looking for.
+class CommitGraph {
+private:
+    std::string graphPath;
+    std::vector<int> versionIds;            // position -> version id
+    std::vector<uint32_t> generations;
+    std::vector<int64_t> timestamps;        // Seconds since the epoch
+    std::vector<uint32_t> parentStart;      // Parents of position p are parentList[parentStart[p], parentStart[p + 1])
+    std::vector<uint32_t> parentList;
+    std::vector<int32_t> positions;         // version id -> position, -1 if absent
+    size_t savedCount;                      // Commits already in the file
+    int maxVersionId;                       // Highest id the repository has saved
+    bool loaded;
+
+public:
+    CommitGraph();
+    
+    void setGraphPath(const std::string& path);
+    // Ids above this are corrupt: load() fails on them and add() refuses
+    // them, so a bad record cannot size the id -> position table
+    void setMaxVersionId(int versionId);
+    int getMaxVersionId() const;
+    
+    bool load();
+    bool exists() const;
+    void clear();
+    
+    // Add a commit in memory. Parent ids the graph does not hold (the unsaved
+    // initial commit) are left out. False if the id is already present or
+    // above the highest version id.
+    bool add(int versionId, const std::vector<int>& parentIds, int64_t timestamp);
+    // Append commits added since the last save; rewrite() replaces the file
+    bool save();
+    bool rewrite();
+    
+    size_t size() const;
+    bool contains(int versionId) const;
+    uint32_t getGeneration(int versionId) const;    // 0 if absent
+    int64_t getTimestamp(int versionId) const;
+    std::vector<int> getParents(int versionId) const;
+    
+    // Whether ancestor is descendant or reachable from it through parents.
+    // Only commits with a generation above ancestor's are walked.
+    bool isAncestor(int ancestorId, int descendantId) const;
+    // Newest common ancestor of a and b, or -1; see Merge::findMergeBase
+    int findMergeBase(int a, int b) const;
+
+private:
+    int32_t positionOf(int versionId) const;
+    void encodeRecord(std::string& out, size_t position) const;
+};
+
+#endif
\ No newline at end of file
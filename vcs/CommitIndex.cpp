@@ -0,0 +1,173 @@
+#include "CommitIndex.h"
+#include "BinaryIO.h"
+#include "MappedFile.h"
+#include "FileSync.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <sys/stat.h>
+
+static const char INDEX_MAGIC[4] = { 'M', 'V', 'C', 'I' };
+static const uint32_t INDEX_VERSION = 1;
+static const size_t INDEX_HEADER_SIZE = 8;
+static const size_t INDEX_RECORD_SIZE = 32;
+
+CommitIndex::CommitIndex() : loaded(false) {
+}
+
+void CommitIndex::setIndexPath(const std::string& path) {
+    indexPath = path;
+    entries.clear();
+    positions.clear();
+    loaded = false;
+}
+
+bool CommitIndex::load() {
+    entries.clear();
+    positions.clear();
+    loaded = false;
+    
+    MappedFile file;
+    if (!file.open(indexPath)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    if (size < INDEX_HEADER_SIZE || data[0] != INDEX_MAGIC[0] || data[1] != INDEX_MAGIC[1] ||
+        data[2] != INDEX_MAGIC[2] || data[3] != INDEX_MAGIC[3] || readU32(data + 4) > INDEX_VERSION) {
+        return false;
+    }
+    
+    // A torn trailing record (crash mid-append) is ignored
+    size_t count = (size - INDEX_HEADER_SIZE) / INDEX_RECORD_SIZE;
+    entries.reserve(count);
+    const char* record = data + INDEX_HEADER_SIZE;
+    for (size_t i = 0; i < count; i++, record += INDEX_RECORD_SIZE) {
+        CommitIndexEntry entry;
+        entry.versionId = static_cast<int>(readU32(record));
+        entry.parentId = static_cast<int>(readU32(record + 4));
+        entry.timestamp = static_cast<int64_t>(readU64(record + 8));
+        entry.packId = readU32(record + 16);
+        entry.messageOffset = readU32(record + 20);
+        entry.fileOffset = readU64(record + 24);
+        
+        // Later records for the same id replace earlier ones
+        auto it = positions.find(entry.versionId);
+        if (it != positions.end()) {
+            entries[it->second] = entry;
+        } else {
+            positions[entry.versionId] = entries.size();
+            entries.push_back(entry);
+        }
+    }
+    
+    loaded = true;
+    
+    // Drop the torn tail so later appends stay record-aligned
+    if ((size - INDEX_HEADER_SIZE) % INDEX_RECORD_SIZE != 0) {
+        file.close();
+        return rewrite();
+    }
+    return true;
+}
+
+bool CommitIndex::exists() const {
+    struct stat info;
+    return stat(indexPath.c_str(), &info) == 0;
+}
+
+bool CommitIndex::put(const CommitIndexEntry& entry) {
+    if (!loaded) {
+        load();
+    }
+    
+    auto it = positions.find(entry.versionId);
+    if (it != positions.end()) {
+        entries[it->second] = entry;
+        return rewrite();
+    }
+    
+    positions[entry.versionId] = entries.size();
+    entries.push_back(entry);
+    
+    // First record creates the file with its header
+    if (!exists()) {
+        return rewrite();
+    }
+    
+    std::ofstream file(indexPath, std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string record;
+    encodeEntry(record, entry);
+    file.write(record.data(), record.size());
+    return file.good();
+}
+
+bool CommitIndex::update(const CommitIndexEntry& entry) {
+    auto it = positions.find(entry.versionId);
+    if (it == positions.end()) {
+        return false;
+    }
+    entries[it->second] = entry;
+    return true;
+}
+
+bool CommitIndex::rewrite() {
+    std::string out;
+    out.reserve(INDEX_HEADER_SIZE + entries.size() * INDEX_RECORD_SIZE);
+    out.append(INDEX_MAGIC, 4);
+    appendU32(out, INDEX_VERSION);
+    for (const auto& entry : entries) {
+        encodeEntry(out, entry);
+    }
+    
+    // Rebuilt from the commit files and the pack if lost, so it is not synced
+    loaded = true;
+    return FileSync::replaceFile(indexPath, out, false);
+}
+
+const std::vector<CommitIndexEntry>& CommitIndex::getEntries() const {
+    return entries;
+}
+
+const CommitIndexEntry* CommitIndex::find(int versionId) const {
+    auto it = positions.find(versionId);
+    if (it != positions.end()) {
+        return &entries[it->second];
+    }
+    return nullptr;
+}
+
+int CommitIndex::getMaxVersionId() const {
+    int maxId = 0;
+    for (const auto& entry : entries) {
+        if (entry.versionId > maxId) {
+            maxId = entry.versionId;
+        }
+    }
+    return maxId;
+}
+
+int64_t CommitIndex::parseTimestamp(const std::string& timestamp) {
+    std::tm timeinfo = {};
+    std::istringstream ss(timestamp);
+    ss >> std::get_time(&timeinfo, "%Y-%m-%d %H:%M:%S");
+    if (ss.fail()) {
+        return 0;
+    }
+    timeinfo.tm_isdst = -1;
+    return static_cast<int64_t>(mktime(&timeinfo));
+}
+
+void CommitIndex::encodeEntry(std::string& out, const CommitIndexEntry& entry) {
+    appendU32(out, static_cast<uint32_t>(entry.versionId));
+    appendU32(out, static_cast<uint32_t>(entry.parentId));
+    appendU64(out, static_cast<uint64_t>(entry.timestamp));
+    appendU32(out, entry.packId);
+    appendU32(out, entry.messageOffset);
+    appendU64(out, entry.fileOffset);
+}
\ No newline at end of file
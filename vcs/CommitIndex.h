@@ -0,0 +1,53 @@
+#ifndef COMMITINDEX_H
+#define COMMITINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// One fixed-size record per saved commit
+struct CommitIndexEntry {
+    int versionId;
+    int parentId;           // -1 when the commit has no parent
+    int64_t timestamp;      // Seconds since the epoch
+    uint32_t packId;        // 0 = loose commit_N.bin file
+    uint32_t messageOffset; // Byte offset of the message inside the commit record
+    uint64_t fileOffset;    // Byte offset of the commit record inside its file
+};
+
+// Append-only index of every commit in data/commits/index.bin, so history
+// can be enumerated with one sequential read instead of probing for files.
+class CommitIndex {
+private:
+    std::string indexPath;
+    std::vector<CommitIndexEntry> entries;
+    std::unordered_map<int, size_t> positions;  // versionId -> entries slot
+    bool loaded;
+    
+public:
+    CommitIndex();
+    
+    void setIndexPath(const std::string& path);
+    
+    bool load();
+    bool exists() const;
+    
+    // Record a commit; appends a record, or rewrites the file if the id was already indexed
+    bool put(const CommitIndexEntry& entry);
+    
+    // Change a record in memory only; rewrite() saves it
+    bool update(const CommitIndexEntry& entry);
+    bool rewrite();
+    
+    const std::vector<CommitIndexEntry>& getEntries() const;
+    const CommitIndexEntry* find(int versionId) const;
+    int getMaxVersionId() const;
+    
+    static int64_t parseTimestamp(const std::string& timestamp);
+    
+private:
+    static void encodeEntry(std::string& out, const CommitIndexEntry& entry);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "CommitPack.h"
+#include "BinaryIO.h"
+#include <algorithm>
+
+static const char PACK_MAGIC[4] = { 'M', 'V', 'C', 'P' };
+static const size_t PACK_HEADER_SIZE = 24;
+static const size_t PACK_ENTRY_SIZE = 24;
+
+CommitPack::CommitPack() : index(nullptr), packId(0), commitCount(0), indexOffset(0) {
+}
+
+bool CommitPack::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    if (size < PACK_HEADER_SIZE || data[0] != PACK_MAGIC[0] || data[1] != PACK_MAGIC[1] ||
+        data[2] != PACK_MAGIC[2] || data[3] != PACK_MAGIC[3] || readU32(data + 4) > COMMIT_PACK_VERSION) {
+        close();
+        return false;
+    }
+    
+    // The index runs to the end of the file; anything else is a damaged pack
+    uint32_t count = readU32(data + 12);
+    uint64_t offset = readU64(data + 16);
+    if (offset < PACK_HEADER_SIZE || offset > size ||
+        (size - offset) != static_cast<uint64_t>(count) * PACK_ENTRY_SIZE) {
+        close();
+        return false;
+    }
+    
+    packId = readU32(data + 8);
+    commitCount = count;
+    indexOffset = offset;
+    index = data + offset;
+    return true;
+}
+
+void CommitPack::close() {
+    file.close();
+    index = nullptr;
+    packId = 0;
+    commitCount = 0;
+    indexOffset = 0;
+}
+
+bool CommitPack::isOpen() const {
+    return index != nullptr;
+}
+
+uint32_t CommitPack::getPackId() const {
+    return packId;
+}
+
+uint32_t CommitPack::getCommitCount() const {
+    return commitCount;
+}
+
+int CommitPack::getVersionId(uint32_t position) const {
+    return static_cast<int>(readU32(index + static_cast<size_t>(position) * PACK_ENTRY_SIZE));
+}
+
+bool CommitPack::find(int versionId, const char*& data, size_t& size, uint64_t* offset) const {
+    uint32_t low = 0;
+    uint32_t high = commitCount;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int found = getVersionId(middle);
+        if (found < versionId) {
+            low = middle + 1;
+        } else if (found > versionId) {
+            high = middle;
+        } else {
+            const char* entry = index + static_cast<size_t>(middle) * PACK_ENTRY_SIZE;
+            uint64_t recordOffset = readU64(entry + 8);
+            uint64_t recordLength = readU64(entry + 16);
+            if (recordOffset < PACK_HEADER_SIZE || recordOffset > indexOffset ||
+                recordLength > indexOffset - recordOffset) {
+                return false;
+            }
+            data = file.data() + recordOffset;
+            size = static_cast<size_t>(recordLength);
+            if (offset) {
+                *offset = recordOffset;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+
+CommitPackWriter::CommitPackWriter(uint32_t packId) {
+    out.append(PACK_MAGIC, 4);
+    appendU32(out, COMMIT_PACK_VERSION);
+    appendU32(out, packId);
+    appendU32(out, 0);      // Commit count, filled in by finish()
+    appendU64(out, 0);      // Index offset, likewise
+}
+
+uint64_t CommitPackWriter::add(int versionId, const char* data, size_t size) {
+    Entry entry = { versionId, out.size(), size };
+    entries.push_back(entry);
+    out.append(data, size);
+    return entry.offset;
+}
+
+size_t CommitPackWriter::getCommitCount() const {
+    return entries.size();
+}
+
+std::string CommitPackWriter::finish() {
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.versionId < b.versionId;
+    });
+    
+    uint64_t indexOffset = out.size();
+    out.reserve(out.size() + entries.size() * PACK_ENTRY_SIZE);
+    for (const Entry& entry : entries) {
+        appendU32(out, static_cast<uint32_t>(entry.versionId));
+        appendU32(out, 0);
+        appendU64(out, entry.offset);
+        appendU64(out, entry.length);
+    }
+    
+    std::string header;
+    appendU32(header, static_cast<uint32_t>(entries.size()));
+    appendU64(header, indexOffset);
+    out.replace(12, header.size(), header);
+    
+    entries.clear();
+    std::string packed;
+    packed.swap(out);
+    return packed;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef COMMITPACK_H
+#define COMMITPACK_H
+
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Pack file layout (all integers little-endian):
+//
+//   Header   magic "MVCP", format version, pack id, commit count,
+//            offset of the index
+//   Records  encoded commits (see CommitFormat.h) back to back
+//   Index    one fixed-size entry per commit, sorted by version id:
+//            version id, record offset and length
+//
+// A pack holds many commits in one file, so loading packed history costs
+// one open and one mapping however long it is.
+
+const uint32_t COMMIT_PACK_VERSION = 1;
+
+class CommitPack {
+private:
+    MappedFile file;
+    const char* index;      // First index entry inside the mapping
+    uint32_t packId;
+    uint32_t commitCount;
+    uint64_t indexOffset;
+
+public:
+    CommitPack();
+    
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    
+    uint32_t getPackId() const;
+    uint32_t getCommitCount() const;
+    int getVersionId(uint32_t position) const;
+    
+    // The encoded record of a commit, by binary search of the index; false
+    // if the pack does not hold it. Only reads, so it is safe on any thread.
+    bool find(int versionId, const char*& data, size_t& size, uint64_t* offset = nullptr) const;
+
+private:
+    CommitPack(const CommitPack&);
+    CommitPack& operator=(const CommitPack&);
+};
+
+// Builds a pack in memory. Records may be added in any order.
+class CommitPackWriter {
+private:
+    struct Entry {
+        int versionId;
+        uint64_t offset;
+        uint64_t length;
+    };
+    
+    std::string out;
+    std::vector<Entry> entries;
+
+public:
+    explicit CommitPackWriter(uint32_t packId);
+    
+    // Offset of the record within the pack
+    uint64_t add(int versionId, const char* data, size_t size);
+    size_t getCommitCount() const;
+    
+    // The finished pack; the writer is empty afterwards
+    std::string finish();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "Compression.h"
+#include "BinaryIO.h"
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <exception>
+
+static const size_t STREAM_BLOCK_SIZE = 256 * 1024;
+static const uint32_t STORED_FLAG = 0x80000000u;
+static const uint64_t MAX_EXPANSION = 255;  // LZ4: no input byte yields more output than this
+
+static const size_t MIN_MATCH = 4;
+static const size_t LAST_LITERALS = 5;      // LZ4: the last 5 bytes are always literals
+static const size_t MATCH_SAFE_END = 12;    // LZ4: no match may start in the last 12 bytes
+static const size_t MAX_OFFSET = 65535;
+static const int HASH_BITS = 16;
+static const int HC_MAX_ATTEMPTS = 64;
+
+static inline uint32_t read32(const char* p) {
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+static inline uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void appendLength(std::string& out, size_t length) {
+    while (length >= 255) {
+        out += static_cast<char>(255);
+        length -= 255;
+    }
+    out += static_cast<char>(length);
+}
+
+static void emitSequence(std::string& out, const char* literals, size_t literalLength,
+                         size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength - MIN_MATCH;
+    unsigned char token = static_cast<unsigned char>(((literalLength < 15 ? literalLength : 15) << 4) |
+                                                     (matchCode < 15 ? matchCode : 15));
+    out += static_cast<char>(token);
+    if (literalLength >= 15) {
+        appendLength(out, literalLength - 15);
+    }
+    out.append(literals, literalLength);
+    out += static_cast<char>(offset & 0xFF);
+    out += static_cast<char>((offset >> 8) & 0xFF);
+    if (matchCode >= 15) {
+        appendLength(out, matchCode - 15);
+    }
+}
+
+static void emitLastLiterals(std::string& out, const char* literals, size_t literalLength) {
+    out += static_cast<char>((literalLength < 15 ? literalLength : 15) << 4);
+    if (literalLength >= 15) {
+        appendLength(out, literalLength - 15);
+    }
+    out.append(literals, literalLength);
+}
+
+static size_t matchLengthAt(const char* src, size_t candidate, size_t pos, size_t limit) {
+    size_t length = 0;
+    while (pos + length < limit && src[candidate + length] == src[pos + length]) {
+        length++;
+    }
+    return length;
+}
+
+size_t Compression::compressBlock(const char* src, size_t srcSize, std::string& out, bool highCompression) {
+    size_t startSize = out.size();
+    if (srcSize < MATCH_SAFE_END + 1) {
+        emitLastLiterals(out, src, srcSize);
+        return out.size() - startSize;
+    }
+    
+    // Positions are stored +1 so that 0 means "empty"
+    std::vector<uint32_t> head(static_cast<size_t>(1) << HASH_BITS, 0);
+    std::vector<uint32_t> chain;
+    if (highCompression) {
+        chain.assign(srcSize, 0);
+    }
+    
+    size_t matchLimit = srcSize - LAST_LITERALS;
+    size_t searchEnd = srcSize - MATCH_SAFE_END;
+    size_t anchor = 0;
+    size_t pos = 0;
+    
+    while (pos < searchEnd) {
+        uint32_t h = hashSequence(read32(src + pos));
+        size_t bestLength = 0;
+        size_t bestOffset = 0;
+        
+        // Fast mode checks the last position with this hash; HC walks the chain
+        uint32_t candidate = head[h];
+        int attempts = highCompression ? HC_MAX_ATTEMPTS : 1;
+        while (candidate != 0 && attempts-- > 0) {
+            size_t candidatePos = candidate - 1;
+            if (pos - candidatePos > MAX_OFFSET) {
+                break;
+            }
+            if (read32(src + candidatePos) == read32(src + pos)) {
+                size_t length = matchLengthAt(src, candidatePos, pos, matchLimit);
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestOffset = pos - candidatePos;
+                }
+            }
+            candidate = highCompression ? chain[candidatePos] : 0;
+        }
+        
+        if (highCompression) {
+            chain[pos] = head[h];
+        }
+        head[h] = static_cast<uint32_t>(pos + 1);
+        
+        if (bestLength < MIN_MATCH) {
+            pos++;
+            continue;
+        }
+        
+        emitSequence(out, src + anchor, pos - anchor, bestOffset, bestLength);
+        
+        // Index the positions covered by the match so later data can refer to them
+        size_t matchEnd = pos + bestLength;
+        for (size_t i = pos + 1; i < matchEnd && i < searchEnd; i++) {
+            uint32_t hi = hashSequence(read32(src + i));
+            if (highCompression) {
+                chain[i] = head[hi];
+            }
+            head[hi] = static_cast<uint32_t>(i + 1);
+        }
+        pos = matchEnd;
+        anchor = pos;
+    }
+    
+    emitLastLiterals(out, src + anchor, srcSize - anchor);
+    return out.size() - startSize;
+}
+
+bool Compression::decompressBlock(const char* src, size_t srcSize, char* dst, size_t dstSize) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+    size_t ip = 0;
+    size_t op = 0;
+    
+    while (ip < srcSize) {
+        unsigned char token = in[ip++];
+        
+        size_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            unsigned char byte;
+            do {
+                if (ip >= srcSize) return false;
+                byte = in[ip++];
+                literalLength += byte;
+            } while (byte == 255);
+        }
+        if (literalLength > srcSize - ip || literalLength > dstSize - op) {
+            return false;
+        }
+        memcpy(dst + op, src + ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        
+        // The final sequence has literals only
+        if (ip == srcSize) {
+            break;
+        }
+        
+        if (srcSize - ip < 2) {
+            return false;
+        }
+        size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return false;
+        }
+        
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15) {
+            unsigned char byte;
+            do {
+                if (ip >= srcSize) return false;
+                byte = in[ip++];
+                matchLength += byte;
+            } while (byte == 255);
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > dstSize - op) {
+            return false;
+        }
+        
+        // Byte by byte: the match may overlap the bytes it produces
+        size_t from = op - offset;
+        for (size_t i = 0; i < matchLength; i++) {
+            dst[op + i] = dst[from + i];
+        }
+        op += matchLength;
+    }
+    
+    return op == dstSize;
+}
+
+std::string Compression::compress(const char* data, size_t size, CompressionCodec codec) {
+    std::string out;
+    out.reserve(size / 2 + 16);
+    appendU64(out, size);
+    
+    for (size_t offset = 0; offset < size; offset += STREAM_BLOCK_SIZE) {
+        size_t rawSize = (size - offset < STREAM_BLOCK_SIZE) ? size - offset : STREAM_BLOCK_SIZE;
+        size_t headerPos = out.size();
+        appendU32(out, static_cast<uint32_t>(rawSize));
+        appendU32(out, 0);
+        
+        size_t storedSize = 0;
+        if (codec != CODEC_NONE) {
+            storedSize = compressBlock(data + offset, rawSize, out, codec == CODEC_LZ4HC);
+        }
+        
+        // Keep incompressible blocks as they are
+        if (codec == CODEC_NONE || storedSize >= rawSize) {
+            out.resize(headerPos + 8);
+            out.append(data + offset, rawSize);
+            putU32(&out[headerPos + 4], static_cast<uint32_t>(rawSize) | STORED_FLAG);
+        } else {
+            putU32(&out[headerPos + 4], static_cast<uint32_t>(storedSize));
+        }
+    }
+    
+    return out;
+}
+
+bool Compression::decompress(const char* data, size_t size, std::string& out) {
+    if (size < 8) {
+        return false;
+    }
+    // The size is read from the stream, so check it against what the input
+    // could expand to before allocating for it
+    uint64_t totalSize = readU64(data);
+    if (totalSize > static_cast<uint64_t>(size - 8) * MAX_EXPANSION) {
+        return false;
+    }
+    try {
+        out.assign(static_cast<size_t>(totalSize), '\0');
+    } catch (const std::exception&) {
+        return false;
+    }
+    
+    size_t ip = 8;
+    size_t op = 0;
+    while (op < totalSize) {
+        if (size - ip < 8) {
+            return false;
+        }
+        uint32_t rawSize = readU32(data + ip);
+        uint32_t storedField = readU32(data + ip + 4);
+        uint32_t storedSize = storedField & ~STORED_FLAG;
+        ip += 8;
+        if (storedSize > size - ip || rawSize > totalSize - op || rawSize == 0) {
+            return false;
+        }
+        
+        if (storedField & STORED_FLAG) {
+            if (storedSize != rawSize) {
+                return false;
+            }
+            memcpy(&out[op], data + ip, rawSize);
+        } else if (!decompressBlock(data + ip, storedSize, &out[op], rawSize)) {
+            return false;
+        }
+        ip += storedSize;
+        op += rawSize;
+    }
+    
+    return ip == size;
+}
+
+const char* Compression::codecName(CompressionCodec codec) {
+    switch (codec) {
+        case CODEC_LZ4:
+            return "lz4";
+        case CODEC_LZ4HC:
+            return "lz4hc";
+        default:
+            return "none";
+    }
+}
+
+bool Compression::parseCodec(const std::string& name, CompressionCodec& codec) {
+    if (name == "none") {
+        codec = CODEC_NONE;
+    } else if (name == "lz4") {
+        codec = CODEC_LZ4;
+    } else if (name == "lz4hc") {
+        codec = CODEC_LZ4HC;
+    } else {
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <string>
+#include <cstddef>
+
+// Block compression for object payloads. Both codecs produce standard LZ4
+// block data and share one decoder; LZ4HC searches harder for matches,
+// trading write speed for a better ratio.
+enum CompressionCodec {
+    CODEC_NONE = 0,
+    CODEC_LZ4 = 1,
+    CODEC_LZ4HC = 2
+};
+
+// A compressed stream is the original size followed by independent blocks:
+//   u64 total size, then per block: u32 raw size, u32 stored size, data
+// The high bit of the stored size marks a block kept uncompressed.
+class Compression {
+public:
+    static std::string compress(const char* data, size_t size, CompressionCodec codec);
+    static bool decompress(const char* data, size_t size, std::string& out);
+    
+    static const char* codecName(CompressionCodec codec);
+    static bool parseCodec(const std::string& name, CompressionCodec& codec);
+    
+    // Single LZ4 block; returns the number of bytes appended to out
+    static size_t compressBlock(const char* src, size_t srcSize, std::string& out, bool highCompression);
+    static bool decompressBlock(const char* src, size_t srcSize, char* dst, size_t dstSize);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "Delta.h"
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+static const size_t BLOCK_SIZE = 16;    // Shortest match worth a copy instruction
+static const char OP_INSERT = 0x00;
+static const char OP_COPY = 0x01;
+
+static void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static bool readVarint(const char* in, size_t size, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < size; shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint64_t hashBlock(const char* data) {
+    uint64_t a, b;
+    memcpy(&a, data, 8);
+    memcpy(&b, data + 8, 8);
+    uint64_t h = (a ^ (b * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 31);
+}
+
+static void flushInsert(std::string& out, const std::string& target, size_t start, size_t end) {
+    if (end > start) {
+        out += OP_INSERT;
+        appendVarint(out, end - start);
+        out.append(target, start, end - start);
+    }
+}
+
+std::string Delta::encode(const std::string& base, const std::string& target) {
+    std::string out;
+    appendVarint(out, base.size());
+    appendVarint(out, target.size());
+    
+    if (base.size() < BLOCK_SIZE || target.size() < BLOCK_SIZE || base.size() >= UINT32_MAX) {
+        flushInsert(out, target, 0, target.size());
+        return out;
+    }
+    
+    // Index the base at block boundaries (offset + 1, 0 = empty slot)
+    size_t blockCount = base.size() / BLOCK_SIZE;
+    size_t tableSize = 1;
+    while (tableSize < blockCount * 2) {
+        tableSize <<= 1;
+    }
+    std::vector<uint32_t> table(tableSize, 0);
+    for (size_t i = 0; i < blockCount; i++) {
+        size_t offset = i * BLOCK_SIZE;
+        table[hashBlock(base.data() + offset) & (tableSize - 1)] = static_cast<uint32_t>(offset + 1);
+    }
+    
+    size_t pos = 0;
+    size_t literalStart = 0;
+    while (pos + BLOCK_SIZE <= target.size()) {
+        uint32_t slot = table[hashBlock(target.data() + pos) & (tableSize - 1)];
+        if (slot == 0 || memcmp(base.data() + slot - 1, target.data() + pos, BLOCK_SIZE) != 0) {
+            pos++;
+            continue;
+        }
+        
+        // Extend the match forwards, then backwards into the pending literal
+        size_t baseStart = slot - 1;
+        size_t length = BLOCK_SIZE;
+        while (baseStart + length < base.size() && pos + length < target.size() &&
+               base[baseStart + length] == target[pos + length]) {
+            length++;
+        }
+        while (baseStart > 0 && pos > literalStart && base[baseStart - 1] == target[pos - 1]) {
+            baseStart--;
+            pos--;
+            length++;
+        }
+        
+        flushInsert(out, target, literalStart, pos);
+        out += OP_COPY;
+        appendVarint(out, baseStart);
+        appendVarint(out, length);
+        
+        pos += length;
+        literalStart = pos;
+    }
+    
+    flushInsert(out, target, literalStart, target.size());
+    return out;
+}
+
+bool Delta::apply(const std::string& base, const char* delta, size_t deltaSize, std::string& target) {
+    size_t pos = 0;
+    uint64_t baseSize, targetSize;
+    if (!readVarint(delta, deltaSize, pos, baseSize) || !readVarint(delta, deltaSize, pos, targetSize) ||
+        baseSize != base.size()) {
+        return false;
+    }
+    
+    // The size comes from the delta, so a corrupt one must not decide the
+    // allocation: every insert byte is in the delta, and each copy (at
+    // least three bytes of it) adds at most the whole base
+    uint64_t maxTargetSize = deltaSize + (deltaSize / 3) * static_cast<uint64_t>(base.size());
+    if (targetSize > maxTargetSize) {
+        return false;
+    }
+    target.clear();
+    target.reserve(static_cast<size_t>(std::min<uint64_t>(targetSize, base.size() + deltaSize)));
+    
+    while (pos < deltaSize) {
+        char op = delta[pos++];
+        if (op == OP_INSERT) {
+            uint64_t length;
+            if (!readVarint(delta, deltaSize, pos, length) || length > deltaSize - pos) {
+                return false;
+            }
+            target.append(delta + pos, static_cast<size_t>(length));
+            pos += static_cast<size_t>(length);
+        } else if (op == OP_COPY) {
+            uint64_t offset, length;
+            if (!readVarint(delta, deltaSize, pos, offset) || !readVarint(delta, deltaSize, pos, length) ||
+                offset > base.size() || length > base.size() - offset) {
+                return false;
+            }
+            target.append(base, static_cast<size_t>(offset), static_cast<size_t>(length));
+        } else {
+            return false;
+        }
+        
+        if (target.size() > targetSize) {
+            return false;
+        }
+    }
+    
+    return target.size() == targetSize;
+}
\ No newline at end of file
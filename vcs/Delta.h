@@ -0,0 +1,21 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <string>
+
+// Binary delta between two versions of a file.
+//
+// A delta starts with the base and target sizes (varints) followed by a
+// sequence of instructions:
+//   0x00 <length> <bytes>      insert literal bytes
+//   0x01 <offset> <length>     copy bytes from the base
+class Delta {
+public:
+    // Build a delta that turns base into target
+    static std::string encode(const std::string& base, const std::string& target);
+    
+    // Rebuild the target from base and delta; false if the delta does not fit base
+    static bool apply(const std::string& base, const char* delta, size_t deltaSize, std::string& target);
+};
+
+#endif
\ No newline at end of file
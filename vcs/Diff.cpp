@@ -0,0 +1,441 @@
+#include "Diff.h"
+#include "LineScanner.h"
+#include <unordered_map>
+#include <algorithm>
+#include <climits>
+
+// ---------------------------------------------------------------------------
+// Myers diff (linear space refinement)
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct MyersContext {
+    const uint32_t* a;
+    const uint32_t* b;
+    char* removed;
+    char* added;
+    std::vector<long> forward;      // Furthest x reached per diagonal, forward search
+    std::vector<long> backward;     // Same for the backward search
+    long diagonalOffset;
+    long maxCost;                   // Give up on a minimal split after this many steps
+};
+
+struct Split {
+    long x;
+    long y;
+};
+
+// Find the middle snake of a[off1, lim1) vs b[off2, lim2). Past maxCost the
+// search settles for the furthest-reaching path instead of a minimal one.
+Split findSplit(MyersContext& ctx, long off1, long lim1, long off2, long lim2) {
+    long* kvdf = ctx.forward.data() + ctx.diagonalOffset;
+    long* kvdb = ctx.backward.data() + ctx.diagonalOffset;
+    long dmin = off1 - lim2;
+    long dmax = lim1 - off2;
+    long fmid = off1 - off2;
+    long bmid = lim1 - lim2;
+    bool odd = ((fmid - bmid) & 1) != 0;
+    long fmin = fmid, fmax = fmid;
+    long bmin = bmid, bmax = bmid;
+    
+    kvdf[fmid] = off1;
+    kvdb[bmid] = lim1;
+    
+    for (long ec = 1;; ec++) {
+        // Extend the forward paths by one edit
+        if (fmin > dmin) kvdf[--fmin - 1] = -1; else ++fmin;
+        if (fmax < dmax) kvdf[++fmax + 1] = -1; else --fmax;
+        
+        for (long d = fmax; d >= fmin; d -= 2) {
+            long i1 = (kvdf[d - 1] >= kvdf[d + 1]) ? kvdf[d - 1] + 1 : kvdf[d + 1];
+            long i2 = i1 - d;
+            while (i1 < lim1 && i2 < lim2 && ctx.a[i1] == ctx.b[i2]) {
+                i1++;
+                i2++;
+            }
+            kvdf[d] = i1;
+            if (odd && bmin <= d && d <= bmax && kvdb[d] <= i1) {
+                return Split{ i1, i2 };
+            }
+        }
+        
+        // Extend the backward paths by one edit
+        if (bmin > dmin) kvdb[--bmin - 1] = LONG_MAX; else ++bmin;
+        if (bmax < dmax) kvdb[++bmax + 1] = LONG_MAX; else --bmax;
+        
+        for (long d = bmax; d >= bmin; d -= 2) {
+            long i1 = (kvdb[d - 1] < kvdb[d + 1]) ? kvdb[d - 1] : kvdb[d + 1] - 1;
+            long i2 = i1 - d;
+            while (i1 > off1 && i2 > off2 && ctx.a[i1 - 1] == ctx.b[i2 - 1]) {
+                i1--;
+                i2--;
+            }
+            kvdb[d] = i1;
+            if (!odd && fmin <= d && d <= fmax && i1 <= kvdf[d]) {
+                return Split{ i1, i2 };
+            }
+        }
+        
+        if (ec < ctx.maxCost) {
+            continue;
+        }
+        
+        // Too expensive: split at whichever path got furthest
+        long fbest = -1, fbest1 = -1;
+        for (long d = fmax; d >= fmin; d -= 2) {
+            long i1 = std::min(kvdf[d], lim1);
+            long i2 = i1 - d;
+            if (lim2 < i2) {
+                i1 = lim2 + d;
+                i2 = lim2;
+            }
+            if (fbest < i1 + i2) {
+                fbest = i1 + i2;
+                fbest1 = i1;
+            }
+        }
+        long bbest = LONG_MAX, bbest1 = LONG_MAX;
+        for (long d = bmax; d >= bmin; d -= 2) {
+            long i1 = std::max(off1, kvdb[d]);
+            long i2 = i1 - d;
+            if (i2 < off2) {
+                i1 = off2 + d;
+                i2 = off2;
+            }
+            if (i1 + i2 < bbest) {
+                bbest = i1 + i2;
+                bbest1 = i1;
+            }
+        }
+        if ((lim1 + lim2) - bbest < fbest - (off1 + off2)) {
+            return Split{ fbest1, fbest - fbest1 };
+        }
+        return Split{ bbest1, bbest - bbest1 };
+    }
+}
+
+void myersCompare(MyersContext& ctx, long off1, long lim1, long off2, long lim2) {
+    // Common prefix and suffix are never part of the edit script
+    while (off1 < lim1 && off2 < lim2 && ctx.a[off1] == ctx.b[off2]) {
+        off1++;
+        off2++;
+    }
+    while (off1 < lim1 && off2 < lim2 && ctx.a[lim1 - 1] == ctx.b[lim2 - 1]) {
+        lim1--;
+        lim2--;
+    }
+    
+    if (off1 == lim1) {
+        std::fill(ctx.added + off2, ctx.added + lim2, 1);
+        return;
+    }
+    if (off2 == lim2) {
+        std::fill(ctx.removed + off1, ctx.removed + lim1, 1);
+        return;
+    }
+    
+    Split split = findSplit(ctx, off1, lim1, off2, lim2);
+    if ((split.x == off1 && split.y == off2) || (split.x == lim1 && split.y == lim2)) {
+        // No progress possible; treat the whole range as replaced
+        std::fill(ctx.removed + off1, ctx.removed + lim1, 1);
+        std::fill(ctx.added + off2, ctx.added + lim2, 1);
+        return;
+    }
+    myersCompare(ctx, off1, split.x, off2, split.y);
+    myersCompare(ctx, split.x, lim1, split.y, lim2);
+}
+
+void runMyers(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+              size_t off1, size_t lim1, size_t off2, size_t lim2,
+              std::vector<char>& removed, std::vector<char>& added) {
+    // Lines that never appear on the other side are changes no matter what,
+    // so leave them out of the (quadratic worst case) search entirely
+    std::unordered_map<uint32_t, uint32_t> inA, inB;
+    for (size_t i = off1; i < lim1; i++) inA[a[i]]++;
+    for (size_t j = off2; j < lim2; j++) inB[b[j]]++;
+    
+    std::vector<uint32_t> keptA, keptB;
+    std::vector<size_t> mapA, mapB;
+    for (size_t i = off1; i < lim1; i++) {
+        if (inB.count(a[i])) {
+            keptA.push_back(a[i]);
+            mapA.push_back(i);
+        } else {
+            removed[i] = 1;
+        }
+    }
+    for (size_t j = off2; j < lim2; j++) {
+        if (inA.count(b[j])) {
+            keptB.push_back(b[j]);
+            mapB.push_back(j);
+        } else {
+            added[j] = 1;
+        }
+    }
+    
+    long n1 = static_cast<long>(keptA.size());
+    long n2 = static_cast<long>(keptB.size());
+    std::vector<char> keptRemoved(n1, 0), keptAdded(n2, 0);
+    
+    MyersContext ctx;
+    ctx.a = keptA.data();
+    ctx.b = keptB.data();
+    ctx.removed = keptRemoved.data();
+    ctx.added = keptAdded.data();
+    ctx.forward.assign(n1 + n2 + 3, 0);
+    ctx.backward.assign(n1 + n2 + 3, 0);
+    ctx.diagonalOffset = n2 + 1;
+    ctx.maxCost = 256;
+    for (long diagonals = n1 + n2 + 3; ctx.maxCost * ctx.maxCost < diagonals; ) {
+        ctx.maxCost <<= 1;
+    }
+    
+    myersCompare(ctx, 0, n1, 0, n2);
+    
+    for (long i = 0; i < n1; i++) {
+        if (keptRemoved[i]) removed[mapA[i]] = 1;
+    }
+    for (long j = 0; j < n2; j++) {
+        if (keptAdded[j]) added[mapB[j]] = 1;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Histogram diff
+// ---------------------------------------------------------------------------
+
+const uint32_t HISTOGRAM_MAX_CHAIN = 64;   // Lines more common than this are never anchors
+
+struct Range {
+    size_t off1, lim1, off2, lim2;
+};
+
+// Find the longest common region around the rarest line shared by both ranges
+bool findAnchor(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                const Range& r, Range& anchor) {
+    std::unordered_map<uint32_t, std::vector<size_t>> positions;
+    for (size_t i = r.off1; i < r.lim1; i++) {
+        positions[a[i]].push_back(i);
+    }
+    
+    bool found = false;
+    size_t bestCount = HISTOGRAM_MAX_CHAIN + 1;
+    size_t bestLength = 0;
+    for (size_t j = r.off2; j < r.lim2; ) {
+        auto it = positions.find(b[j]);
+        size_t next = j + 1;
+        if (it != positions.end() && it->second.size() <= bestCount) {
+            for (size_t i : it->second) {
+                size_t s1 = i, s2 = j, e1 = i + 1, e2 = j + 1;
+                size_t rarest = it->second.size();
+                while (s1 > r.off1 && s2 > r.off2 && a[s1 - 1] == b[s2 - 1]) {
+                    s1--;
+                    s2--;
+                    rarest = std::min(rarest, positions[a[s1]].size());
+                }
+                while (e1 < r.lim1 && e2 < r.lim2 && a[e1] == b[e2]) {
+                    rarest = std::min(rarest, positions[a[e1]].size());
+                    e1++;
+                    e2++;
+                }
+                if (rarest < bestCount || (rarest == bestCount && e1 - s1 > bestLength)) {
+                    bestCount = rarest;
+                    bestLength = e1 - s1;
+                    anchor = Range{ s1, e1, s2, e2 };
+                    found = true;
+                }
+                next = std::max(next, e2);
+            }
+        }
+        j = next;
+    }
+    return found;
+}
+
+void runHistogram(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                  std::vector<char>& removed, std::vector<char>& added) {
+    // Explicit work list: deep recursion on large files would blow the stack
+    std::vector<Range> work;
+    work.push_back(Range{ 0, a.size(), 0, b.size() });
+    
+    while (!work.empty()) {
+        Range r = work.back();
+        work.pop_back();
+        
+        while (r.off1 < r.lim1 && r.off2 < r.lim2 && a[r.off1] == b[r.off2]) {
+            r.off1++;
+            r.off2++;
+        }
+        while (r.off1 < r.lim1 && r.off2 < r.lim2 && a[r.lim1 - 1] == b[r.lim2 - 1]) {
+            r.lim1--;
+            r.lim2--;
+        }
+        
+        if (r.off1 == r.lim1) {
+            std::fill(added.begin() + r.off2, added.begin() + r.lim2, 1);
+            continue;
+        }
+        if (r.off2 == r.lim2) {
+            std::fill(removed.begin() + r.off1, removed.begin() + r.lim1, 1);
+            continue;
+        }
+        
+        Range anchor;
+        if (!findAnchor(a, b, r, anchor)) {
+            // Only very common lines left: fall back to Myers for this range
+            runMyers(a, b, r.off1, r.lim1, r.off2, r.lim2, removed, added);
+            continue;
+        }
+        
+        work.push_back(Range{ anchor.lim1, r.lim1, anchor.lim2, r.lim2 });
+        work.push_back(Range{ r.off1, anchor.off1, r.off2, anchor.off2 });
+    }
+}
+
+struct ChangeBlock {
+    size_t off1, lim1, off2, lim2;
+};
+
+void appendLine(std::string& out, char prefix, std::string_view line) {
+    out += prefix;
+    out.append(line.data(), line.size());
+    if (line.empty() || line.back() != '\n') {
+        out += "\n\\ No newline at end of file\n";
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Public interface
+// ---------------------------------------------------------------------------
+
+void Diff::splitLines(const std::string& text, std::vector<std::string_view>& lines) {
+    LineScanner::splitLines(text, lines);
+}
+
+void Diff::assignLineIds(const std::vector<std::string_view>& oldLines,
+                         const std::vector<std::string_view>& newLines,
+                         std::vector<uint32_t>& oldIds, std::vector<uint32_t>& newIds) {
+    std::unordered_map<std::string_view, uint32_t, LineHash> ids;
+    ids.reserve(oldLines.size() + newLines.size());
+    
+    oldIds.resize(oldLines.size());
+    for (size_t i = 0; i < oldLines.size(); i++) {
+        oldIds[i] = ids.emplace(oldLines[i], static_cast<uint32_t>(ids.size())).first->second;
+    }
+    newIds.resize(newLines.size());
+    for (size_t i = 0; i < newLines.size(); i++) {
+        newIds[i] = ids.emplace(newLines[i], static_cast<uint32_t>(ids.size())).first->second;
+    }
+}
+
+void Diff::diffIds(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                   DiffAlgorithm algorithm, std::vector<char>& removed, std::vector<char>& added) {
+    removed.assign(a.size(), 0);
+    added.assign(b.size(), 0);
+    if (algorithm == DIFF_HISTOGRAM) {
+        runHistogram(a, b, removed, added);
+    } else {
+        runMyers(a, b, 0, a.size(), 0, b.size(), removed, added);
+    }
+}
+
+DiffResult Diff::diffLines(const std::string& oldText, const std::string& newText,
+                           DiffAlgorithm algorithm, int context) {
+    DiffResult result;
+    result.linesAdded = 0;
+    result.linesRemoved = 0;
+    
+    std::vector<std::string_view> oldLines, newLines;
+    splitLines(oldText, oldLines);
+    splitLines(newText, newLines);
+    
+    std::vector<uint32_t> oldIds, newIds;
+    assignLineIds(oldLines, newLines, oldIds, newIds);
+    
+    std::vector<char> removed, added;
+    diffIds(oldIds, newIds, algorithm, removed, added);
+    
+    // Collect runs of changed lines; unchanged lines pair up one to one
+    std::vector<ChangeBlock> blocks;
+    size_t n1 = oldLines.size(), n2 = newLines.size();
+    size_t i = 0, j = 0;
+    while (i < n1 || j < n2) {
+        if ((i < n1 && removed[i]) || (j < n2 && added[j])) {
+            ChangeBlock block = { i, i, j, j };
+            while (i < n1 && removed[i]) i++;
+            while (j < n2 && added[j]) j++;
+            block.lim1 = i;
+            block.lim2 = j;
+            result.linesRemoved += static_cast<int>(block.lim1 - block.off1);
+            result.linesAdded += static_cast<int>(block.lim2 - block.off2);
+            blocks.push_back(block);
+        } else {
+            i++;
+            j++;
+        }
+    }
+    
+    size_t ctx = context > 0 ? static_cast<size_t>(context) : 0;
+    for (size_t first = 0; first < blocks.size(); ) {
+        // Blocks closer than two contexts apart share a hunk
+        size_t last = first;
+        while (last + 1 < blocks.size() && blocks[last + 1].off1 - blocks[last].lim1 <= 2 * ctx) {
+            last++;
+        }
+        
+        size_t start1 = blocks[first].off1 > ctx ? blocks[first].off1 - ctx : 0;
+        size_t start2 = blocks[first].off2 - (blocks[first].off1 - start1);
+        size_t end1 = std::min(n1, blocks[last].lim1 + ctx);
+        size_t end2 = blocks[last].lim2 + (end1 - blocks[last].lim1);
+        
+        DiffHunk hunk;
+        hunk.oldCount = static_cast<int>(end1 - start1);
+        hunk.newCount = static_cast<int>(end2 - start2);
+        hunk.oldStart = static_cast<int>(hunk.oldCount > 0 ? start1 + 1 : start1);
+        hunk.newStart = static_cast<int>(hunk.newCount > 0 ? start2 + 1 : start2);
+        
+        size_t x = start1, y = start2;
+        while (x < end1 || y < end2) {
+            if (x < end1 && removed[x]) {
+                hunk.lines.push_back("-" + std::string(oldLines[x++]));
+            } else if (y < end2 && added[y]) {
+                hunk.lines.push_back("+" + std::string(newLines[y++]));
+            } else {
+                hunk.lines.push_back(" " + std::string(oldLines[x]));
+                x++;
+                y++;
+            }
+        }
+        
+        result.hunks.push_back(hunk);
+        first = last + 1;
+    }
+    
+    return result;
+}
+
+std::string Diff::unifiedDiff(const std::string& oldName, const std::string& newName,
+                              const std::string& oldText, const std::string& newText,
+                              DiffAlgorithm algorithm, int context) {
+    return formatUnified(oldName, newName, diffLines(oldText, newText, algorithm, context));
+}
+
+std::string Diff::formatUnified(const std::string& oldName, const std::string& newName,
+                                const DiffResult& result) {
+    if (result.hunks.empty()) {
+        return "";
+    }
+    
+    std::string out = "--- " + oldName + "\n+++ " + newName + "\n";
+    for (const auto& hunk : result.hunks) {
+        out += "@@ -" + std::to_string(hunk.oldStart) + "," + std::to_string(hunk.oldCount) +
+               " +" + std::to_string(hunk.newStart) + "," + std::to_string(hunk.newCount) + " @@\n";
+        for (const auto& line : hunk.lines) {
+            appendLine(out, line[0], std::string_view(line).substr(1));
+        }
+    }
+    return out;
+}
\ No newline at end of file
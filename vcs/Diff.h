@@ -0,0 +1,55 @@
+#ifndef DIFF_H
+#define DIFF_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+enum DiffAlgorithm {
+    DIFF_MYERS,         // Minimal edit script (Myers O(ND), linear space)
+    DIFF_HISTOGRAM      // Anchors on rare common lines, like patience diff
+};
+
+// One @@ block of a unified diff. Line numbers are 1-based as printed.
+struct DiffHunk {
+    int oldStart;
+    int oldCount;
+    int newStart;
+    int newCount;
+    std::vector<std::string> lines;     // Each prefixed with ' ', '-' or '+'
+};
+
+struct DiffResult {
+    std::vector<DiffHunk> hunks;
+    int linesAdded;
+    int linesRemoved;
+};
+
+// Line-level diff between two versions of a file. Lines are mapped to
+// integer ids first, so the edit script search compares ints, not strings.
+class Diff {
+public:
+    static DiffResult diffLines(const std::string& oldText, const std::string& newText,
+                                DiffAlgorithm algorithm = DIFF_MYERS, int context = 3);
+    
+    // Full unified diff text with ---/+++ headers; empty when the texts are equal
+    static std::string unifiedDiff(const std::string& oldName, const std::string& newName,
+                                   const std::string& oldText, const std::string& newText,
+                                   DiffAlgorithm algorithm = DIFF_MYERS, int context = 3);
+    static std::string formatUnified(const std::string& oldName, const std::string& newName,
+                                     const DiffResult& result);
+    
+    // Edit script on id sequences: marks which entries of a were removed
+    // and which entries of b were added
+    static void diffIds(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                        DiffAlgorithm algorithm, std::vector<char>& removed, std::vector<char>& added);
+    
+    // Split text into lines (each keeps its '\n') and give equal lines equal ids
+    static void splitLines(const std::string& text, std::vector<std::string_view>& lines);
+    static void assignLineIds(const std::vector<std::string_view>& oldLines,
+                              const std::vector<std::string_view>& newLines,
+                              std::vector<uint32_t>& oldIds, std::vector<uint32_t>& newIds);
+};
+
+#endif
\ No newline at end of file
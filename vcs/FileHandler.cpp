@@ -1,24 +1,70 @@
 #include "FileHandler.h"
+#include "CommitFormat.h"
+#include "FileSync.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 #include <iostream>
 #include <sstream>
-#include <direct.h>
+#include <mutex>
+#include <algorithm>
+#include <cstdio>
 #include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+// Below this many commits, starting threads costs more than it saves
+static const size_t PARALLEL_LOAD_THRESHOLD = 256;
 
-FileHandler::FileHandler() : dataPath("data") {
+FileHandler::FileHandler() : dataPath("data"), objectStore("data/objects") {
+    commitIndex.setIndexPath(getCommitIndexPath());
+    commitGraph.setGraphPath(getCommitGraphPath());
+    workingIndex.setIndexPath(getWorkingIndexPath());
+    searchIndex.setIndexPath(getSearchIndexPath());
+    journal.setPaths(getJournalPath(), dataPath);
+    objectStore.setJournal(&journal);
 }
 
-FileHandler::FileHandler(const std::string& path) : dataPath(path) {
+FileHandler::FileHandler(const std::string& path) : dataPath(path), objectStore(path + "/objects") {
+    commitIndex.setIndexPath(getCommitIndexPath());
+    commitGraph.setGraphPath(getCommitGraphPath());
+    workingIndex.setIndexPath(getWorkingIndexPath());
+    searchIndex.setIndexPath(getSearchIndexPath());
+    journal.setPaths(getJournalPath(), dataPath);
+    objectStore.setJournal(&journal);
 }
 
 FileHandler::~FileHandler() {
+    // Sealed transactions still waiting on a batch get written now
+    journal.flush();
+    indexPendingCommits();
 }
 
 void FileHandler::setDataPath(const std::string& path) {
+    // Finish anything still batched against the old location first
+    journal.flush();
+    indexPendingCommits();
+    
     dataPath = path;
+    commitPack.close();
+    objectStore.setObjectsPath(path + "/objects");
+    commitIndex.setIndexPath(getCommitIndexPath());
+    commitGraph.setGraphPath(getCommitGraphPath());
+    workingIndex.setIndexPath(getWorkingIndexPath());
+    searchIndex.setIndexPath(getSearchIndexPath());
+    journal.setPaths(getJournalPath(), path);
+}
+
+ObjectStore* FileHandler::getObjectStore() {
+    return &objectStore;
 }
 
 bool FileHandler::createDirectory(const std::string& path) {
+#ifdef _WIN32
     return _mkdir(path.c_str()) == 0 || directoryExists(path);
+#else
+    return mkdir(path.c_str(), 0755) == 0 || directoryExists(path);
+#endif
 }
 
 bool FileHandler::directoryExists(const std::string& path) {
@@ -28,34 +74,141 @@ bool FileHandler::directoryExists(const std::string& path) {
 
 bool FileHandler::saveCommit(Commit* commit) {
     if (!commit) return false;
+    TRACE_SCOPE("file.saveCommit");
     
-    std::string filepath = getCommitFilePath(commit->versionId);
-    std::ofstream file(filepath);
-    
-    if (!file.is_open()) {
+    // Only the changes from the first parent, most of the time
+    uint32_t listingDepth;
+    std::string encoded = CommitWriter::encode(commit, &listingDepth);
+    TRACE_COUNT("commit.bytes_written", encoded.size());
+    if (!writeCommitFile(commit->versionId, encoded)) {
         return false;
     }
+    commit->listingDepth = listingDepth;
     
-    // Save commit metadata
-    file << "VERSION_ID:" << commit->versionId << std::endl;
-    file << "MESSAGE:" << commit->message << std::endl;
-    file << "TIMESTAMP:" << commit->timestamp << std::endl;
-    file << "FILES_COUNT:" << commit->files.size() << std::endl;
+    int parentId = commit->prev ? commit->prev->versionId : -1;
+    CommitIndexEntry entry = makeIndexEntry(commit, CommitWriter::getMessageOffset(encoded), parentId);
     
-    // Save files
-    for (const auto& fileEntry : commit->files) {
-        file << "FILE_START:" << fileEntry.first << std::endl;
-        file << "CONTENT_LENGTH:" << fileEntry.second.length() << std::endl;
-        file << fileEntry.second << std::endl;
-        file << "FILE_END" << std::endl;
+    // Queries see the commit in the graph at once; the graph file, like the
+    // index, must not name it before the commit file is on disk
+    std::vector<int> parentIds;
+    for (uint32_t i = 0; i < commit->parentCount; i++) {
+        parentIds.push_back(commit->parents[i]->versionId);
+    }
+    if (commit->versionId > commitGraph.getMaxVersionId()) {
+        commitGraph.setMaxVersionId(commit->versionId);
     }
+    commitGraph.add(commit->versionId, parentIds, entry.timestamp);
     
-    file.close();
-    return true;
+    if (journal.isOpen() || journal.hasUnflushed()) {
+        pendingIndexEntries.push_back(entry);
+        return true;
+    }
+    bool ok = commitIndex.put(entry);
+    return commitGraph.save() && ok;
+}
+
+bool FileHandler::writeCommitFile(int versionId, const std::string& encoded) {
+    // Header, offset table and payload go out in a single write
+    return writeFile(getCommitFilePath(versionId), encoded);
+}
+
+bool FileHandler::writeFile(const std::string& path, const std::string& data) {
+    // Staged in the open transaction, or else replaced atomically on its own
+    return journal.write(path, data) || FileSync::replaceFile(path, data, true);
+}
+
+void FileHandler::beginTransaction() {
+    journal.begin();
+}
+
+bool FileHandler::commitTransaction() {
+    bool ok = journal.commit();
+    return indexPendingCommits() && ok;
+}
+
+void FileHandler::beginBatch() {
+    journal.beginBatch();
+}
+
+bool FileHandler::endBatch() {
+    bool ok = journal.endBatch();
+    return indexPendingCommits() && ok;
+}
+
+bool FileHandler::recoverJournal() {
+    return journal.recover();
+}
+
+bool FileHandler::indexPendingCommits() {
+    if (journal.isOpen() || journal.hasUnflushed()) {
+        return true;
+    }
+    
+    bool ok = true;
+    for (const CommitIndexEntry& entry : pendingIndexEntries) {
+        ok = commitIndex.put(entry) && ok;
+    }
+    pendingIndexEntries.clear();
+    return commitGraph.save() && ok;
+}
+
+Commit* FileHandler::loadCommit(int versionId, Arena& arena, TreePool& trees, const Commit* previous,
+                                std::vector<int>* parentIds, int defaultParentId, const CommitLookup& findCommit) {
+    Commit* binaryCommit = loadBinaryCommit(versionId, arena, trees, previous, parentIds, defaultParentId,
+                                            findCommit);
+    if (binaryCommit) {
+        return binaryCommit;
+    }
+    
+    // Fall back to the original text format. Its contents have now been
+    // moved to the object store, so write a binary copy that later loads
+    // can read without touching the file bodies again.
+    TRACE_SCOPE("file.loadTextCommit");
+    Commit* commit = loadTextCommit(getTextCommitFilePath(versionId), arena, trees);
+    if (commit) {
+        FileSync::replaceFile(getCommitFilePath(versionId), CommitWriter::encode(commit), false);
+        if (parentIds) {
+            parentIds->clear();
+            if (defaultParentId >= 0) {
+                parentIds->push_back(defaultParentId);
+            }
+        }
+    }
+    return commit;
+}
+
+Commit* FileHandler::loadBinaryCommit(int versionId, Arena& arena, TreePool& trees, const Commit* previous,
+                                      std::vector<int>* parentIds, int defaultParentId,
+                                      const CommitLookup& findCommit) {
+    TRACE_SCOPE("file.loadCommit");
+    // Packed commits need no file of their own
+    CommitReader reader;
+    const char* record;
+    size_t size;
+    if ((commitPack.find(versionId, record, size) && reader.parse(record, size)) ||
+        reader.open(getCommitFilePath(versionId))) {
+        if (parentIds) {
+            parentIds->clear();
+            if (reader.hasParents()) {
+                for (uint32_t i = 0; i < reader.getParentCount(); i++) {
+                    parentIds->push_back(reader.getParentId(i));
+                }
+            } else if (defaultParentId >= 0) {
+                parentIds->push_back(defaultParentId);
+            }
+        }
+        // In a linear history the base is the commit loaded just before
+        const Commit* base = nullptr;
+        int baseId = reader.getBaseId();
+        if (baseId != 0) {
+            base = (previous && previous->versionId == baseId) ? previous : findCommit ? findCommit(baseId) : nullptr;
+        }
+        return reader.toCommit(&objectStore, arena, trees, previous ? previous->files : FileTree(), base);
+    }
+    return nullptr;
 }
 
-Commit* FileHandler::loadCommit(int versionId) {
-    std::string filepath = getCommitFilePath(versionId);
+Commit* FileHandler::loadTextCommit(const std::string& filepath, Arena& arena, TreePool& trees) {
     std::ifstream file(filepath);
     
     if (!file.is_open()) {
@@ -84,42 +237,54 @@ Commit* FileHandler::loadCommit(int versionId) {
         filesCount = std::stoi(line.substr(12));
     } else return nullptr;
     
-    // Create commit
-    Commit* commit = new Commit(loadedVersionId, message);
-    commit->timestamp = timestamp;
+    // Create commit; if the rest does not parse, it is freed with the arena
+    Commit* commit = arena.create<Commit>(arena, trees, loadedVersionId, message, timestamp, &objectStore);
     
     // Read files
     for (int i = 0; i < filesCount; i++) {
         std::string filename, content;
         int contentLength;
         
-        if (std::getline(file, line) && line.substr(0, 11) == "FILE_START:") {
+        if (!std::getline(file, line)) {
+            return nullptr;
+        }
+        
+        // Blob reference: "FILE_BLOB:<blob id> <size> <filename>"
+        if (line.substr(0, 10) == "FILE_BLOB:") {
+            size_t idEnd = line.find(' ', 10);
+            size_t sizeEnd = (idEnd == std::string::npos) ? idEnd : line.find(' ', idEnd + 1);
+            if (sizeEnd == std::string::npos) {
+                return nullptr;
+            }
+            commit->addBlob(line.substr(sizeEnd + 1), line.substr(10, idEnd - 10),
+                            std::stoul(line.substr(idEnd + 1, sizeEnd - idEnd - 1)));
+            continue;
+        }
+        
+        // Older commit files carry the content inline
+        if (line.substr(0, 11) == "FILE_START:") {
             filename = line.substr(11);
         } else {
-            delete commit;
             return nullptr;
         }
         
         if (std::getline(file, line) && line.substr(0, 15) == "CONTENT_LENGTH:") {
             contentLength = std::stoi(line.substr(15));
         } else {
-            delete commit;
             return nullptr;
         }
         
-        // Read content
-        std::stringstream contentStream;
-        char ch;
-        for (int j = 0; j < contentLength; j++) {
-            file.get(ch);
-            contentStream << ch;
-        }
-        content = contentStream.str();
+        // Read content in one go
+        content.resize(contentLength);
+        if (contentLength > 0 && !file.read(&content[0], contentLength)) {
+            return nullptr;
+        }
         
         // Skip newline and FILE_END
         std::getline(file, line); // newline
         std::getline(file, line); // FILE_END
         
+        // Move inline content into the object store
         commit->addFile(filename, content);
     }
     
@@ -127,35 +292,247 @@ Commit* FileHandler::loadCommit(int versionId) {
     return commit;
 }
 
-std::vector<Commit*> FileHandler::loadAllCommits() {
+std::vector<Commit*> FileHandler::loadAllCommits(Arena& arena, TreePool& trees,
+                                                 std::vector<std::vector<int>>& parentIds) {
+    TRACE_SCOPE("file.loadAllCommits");
     std::vector<Commit*> commits;
+    parentIds.clear();
+    commitPack.open(getCommitPackPath());
     
-    // Try to load commits starting from version 1
-    for (int i = 1; i < 1000; i++) { // Reasonable upper limit
-        Commit* commit = loadCommit(i);
-        if (commit) {
-            commits.push_back(commit);
-        } else {
+    // Commits loaded so far by id, the bases of the ones saved as changes
+    std::vector<Commit*> loadedById;
+    auto addLoaded = [&](Commit* commit) {
+        if (static_cast<size_t>(commit->versionId) >= loadedById.size()) {
+            loadedById.resize(static_cast<size_t>(commit->versionId) + 1, nullptr);
+        }
+        loadedById[commit->versionId] = commit;
+    };
+    CommitLookup findLoaded = [&](int versionId) -> const Commit* {
+        return (versionId > 0 && static_cast<size_t>(versionId) < loadedById.size()) ? loadedById[versionId] : nullptr;
+    };
+    
+    // Enumerate indexed commits with one sequential read of the index
+    int lastIndexed = 0;
+    if (commitIndex.load()) {
+        const std::vector<CommitIndexEntry>& entries = commitIndex.getEntries();
+        std::vector<Commit*> loaded(entries.size(), nullptr);
+        std::vector<std::vector<int>> loadedParents(entries.size());
+        
+        // Binary commit files are independent and only read, so large
+        // histories are parsed across a thread pool
+        if (entries.size() >= PARALLEL_LOAD_THRESHOLD && ThreadPool::getDefaultThreadCount() > 1) {
+            ThreadPool pool;
+            std::mutex arenaMutex;
+            pool.parallelFor(entries.size(), [&](size_t begin, size_t end) {
+                // Each chunk fills an arena of its own, handed over when done.
+                // A base outside the chunk is not loaded yet; such commits,
+                // up to the next full listing, are left to the pass below.
+                Arena chunkArena;
+                size_t i = begin;
+                CommitLookup findInChunk = [&](int baseId) -> const Commit* {
+                    const CommitIndexEntry* base = commitIndex.find(baseId);
+                    size_t position = base ? static_cast<size_t>(base - entries.data()) : end;
+                    return (position >= begin && position < i) ? loaded[position] : nullptr;
+                };
+                for (; i < end; i++) {
+                    loaded[i] = loadBinaryCommit(entries[i].versionId, chunkArena, trees,
+                                                 (i > begin) ? loaded[i - 1] : nullptr,
+                                                 &loadedParents[i], entries[i].parentId, findInChunk);
+                }
+                std::lock_guard<std::mutex> lock(arenaMutex);
+                arena.adopt(chunkArena);
+            });
+        }
+        
+        // Whatever is left (text-format commits write to the object store) runs here
+        // Version 1 records name no parents; the index has the first one
+        commits.reserve(entries.size());
+        parentIds.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            Commit* commit = loaded[i] ? loaded[i] :
+                loadCommit(entries[i].versionId, arena, trees, commits.empty() ? nullptr : commits.back(),
+                           &loadedParents[i], entries[i].parentId, findLoaded);
+            if (commit) {
+                commits.push_back(commit);
+                parentIds.push_back(std::move(loadedParents[i]));
+                addLoaded(commit);
+            }
+        }
+        lastIndexed = commitIndex.getMaxVersionId();
+    }
+    
+    // Pick up commit files the index does not know about yet: repositories
+    // created before the index existed, or a commit saved just before a crash
+    for (int i = lastIndexed + 1; ; i++) {
+        std::vector<int> parents;
+        Commit* commit = loadCommit(i, arena, trees, commits.empty() ? nullptr : commits.back(), &parents, i - 1,
+                                    findLoaded);
+        if (!commit) {
             break; // No more commits
         }
+        commits.push_back(commit);
+        parentIds.push_back(parents);
+        addLoaded(commit);
+        
+        if (!commitIndex.find(i)) {
+            // The message offset comes from the record as stored
+            CommitIndexEntry entry = makeIndexEntry(commit, 0, parents.empty() ? -1 : parents[0]);
+            const char* record;
+            size_t size;
+            MappedFile file;
+            if (commitPack.find(i, record, size, &entry.fileOffset)) {
+                entry.packId = commitPack.getPackId();
+                entry.messageOffset = CommitWriter::getMessageOffset(record);
+            } else if (file.open(getCommitFilePath(i)) && CommitReader::isBinaryCommit(file.data(), file.size())) {
+                entry.messageOffset = CommitWriter::getMessageOffset(file.data());
+            }
+            commitIndex.put(entry);
+        }
     }
     
+    syncCommitGraph(commits, parentIds);
     return commits;
 }
 
-bool FileHandler::saveRepositoryMetadata(int nextVersionId, bool initialized) {
-    std::string filepath = getMetadataFilePath();
-    std::ofstream file(filepath);
+void FileHandler::syncCommitGraph(const std::vector<Commit*>& commits,
+                                  const std::vector<std::vector<int>>& parentIds) {
+    // Every loaded commit is in the index by now, so its highest id bounds
+    // the graph's; a graph naming a higher one is rebuilt
+    commitGraph.setMaxVersionId(commitIndex.getMaxVersionId());
     
-    if (!file.is_open()) {
+    // A graph that holds exactly the loaded commits is current
+    bool current = commitGraph.load() && commitGraph.size() == commits.size();
+    for (size_t i = 0; current && i < commits.size(); i++) {
+        current = commitGraph.contains(commits[i]->versionId);
+    }
+    if (current) {
+        return;
+    }
+    
+    // Missing, or behind after a crash: rebuild it, parents first
+    std::vector<size_t> order(commits.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return commits[a]->versionId < commits[b]->versionId; });
+    commitGraph.clear();
+    for (size_t i : order) {
+        commitGraph.add(commits[i]->versionId, parentIds[i],
+                        CommitIndex::parseTimestamp(commits[i]->getTimestamp()));
+    }
+    commitGraph.rewrite();
+}
+
+const CommitIndex& FileHandler::getCommitIndex() const {
+    return commitIndex;
+}
+
+const CommitGraph& FileHandler::getCommitGraph() const {
+    return commitGraph;
+}
+
+bool FileHandler::repackCommits(size_t& packedCount) {
+    TRACE_SCOPE("file.repackCommits");
+    packedCount = 0;
+    
+    // Every commit made so far has to be in its commit file and indexed,
+    // and the journal empty so recovery cannot bring packed files back
+    if (journal.isOpen() || !journal.flush() || !indexPendingCommits() || !journal.checkpoint()) {
+        return false;
+    }
+    commitIndex.load();
+    commitPack.open(getCommitPackPath());
+    
+    // Every commit the index or the current pack knows of
+    std::vector<int> versionIds;
+    for (const CommitIndexEntry& entry : commitIndex.getEntries()) {
+        versionIds.push_back(entry.versionId);
+    }
+    for (uint32_t i = 0; i < commitPack.getCommitCount(); i++) {
+        versionIds.push_back(commitPack.getVersionId(i));
+    }
+    std::sort(versionIds.begin(), versionIds.end());
+    versionIds.erase(std::unique(versionIds.begin(), versionIds.end()), versionIds.end());
+    
+    uint32_t packId = commitPack.isOpen() ? commitPack.getPackId() + 1 : 1;
+    CommitPackWriter writer(packId);
+    std::vector<int> looseIds;
+    for (int versionId : versionIds) {
+        const char* record;
+        size_t size;
+        MappedFile file;
+        if (commitPack.find(versionId, record, size)) {
+            // Already packed
+        } else if (file.open(getCommitFilePath(versionId)) && CommitReader::isBinaryCommit(file.data(), file.size())) {
+            record = file.data();
+            size = file.size();
+            looseIds.push_back(versionId);
+        } else {
+            continue;   // Still only in the text format; left where it is
+        }
+        
+        uint64_t offset = writer.add(versionId, record, size);
+        const CommitIndexEntry* indexed = commitIndex.find(versionId);
+        if (indexed) {
+            CommitIndexEntry entry = *indexed;
+            entry.packId = packId;
+            entry.fileOffset = offset;
+            commitIndex.update(entry);
+        }
+    }
+    packedCount = writer.getCommitCount();
+    if (looseIds.empty()) {
+        commitIndex.load();
+        return true;
+    }
+    
+    // The new pack holds everything the old one did, so it simply replaces
+    // it; Windows cannot replace a mapped file, so the old one is unmapped
+    // first. It is synced before the loose files it replaces are deleted.
+    std::string packed = writer.finish();
+    commitPack.close();
+    if (!FileSync::replaceFile(getCommitPackPath(), packed, true) || !commitPack.open(getCommitPackPath())) {
+        commitIndex.load();
+        commitPack.open(getCommitPackPath());
         return false;
     }
+    bool ok = commitIndex.rewrite();
     
+    for (int versionId : looseIds) {
+        std::remove(getCommitFilePath(versionId).c_str());
+        std::remove(getTextCommitFilePath(versionId).c_str());
+    }
+    return FileSync::syncDirectory(dataPath + "/commits") && ok;
+}
+
+WorkingIndex* FileHandler::getWorkingIndex() {
+    return &workingIndex;
+}
+
+SearchIndex* FileHandler::getSearchIndex() {
+    return &searchIndex;
+}
+
+CommitIndexEntry FileHandler::makeIndexEntry(Commit* commit, uint32_t messageOffset, int parentId) {
+    CommitIndexEntry entry;
+    entry.versionId = commit->versionId;
+    entry.parentId = parentId;
+    entry.timestamp = CommitIndex::parseTimestamp(std::string(commit->timestamp));
+    entry.packId = 0;
+    entry.messageOffset = messageOffset;
+    entry.fileOffset = 0;
+    return entry;
+}
+
+bool FileHandler::saveRepositoryMetadata(int nextVersionId, bool initialized) {
+    std::ostringstream file;
     file << "NEXT_VERSION_ID:" << nextVersionId << std::endl;
     file << "INITIALIZED:" << (initialized ? "1" : "0") << std::endl;
+    file << "DELTA_KEYFRAME_INTERVAL:" << objectStore.getKeyframeInterval() << std::endl;
+    file << "COMPRESSION:" << Compression::codecName(objectStore.getCompression()) << std::endl;
     
-    file.close();
-    return true;
+    return writeFile(getMetadataFilePath(), file.str());
 }
 
 bool FileHandler::loadRepositoryMetadata(int& nextVersionId, bool& initialized) {
@@ -176,10 +553,71 @@ bool FileHandler::loadRepositoryMetadata(int& nextVersionId, bool& initialized)
         initialized = (line.substr(12) == "1");
     } else return false;
     
+    // Optional storage settings; older metadata files stop here
+    while (std::getline(file, line)) {
+        if (line.substr(0, 24) == "DELTA_KEYFRAME_INTERVAL:") {
+            objectStore.setKeyframeInterval(static_cast<uint32_t>(std::stoul(line.substr(24))));
+        } else if (line.substr(0, 12) == "COMPRESSION:") {
+            CompressionCodec codec;
+            if (Compression::parseCodec(line.substr(12), codec)) {
+                objectStore.setCompression(codec);
+            }
+        }
+    }
+    
     file.close();
     return true;
 }
 
+bool FileHandler::saveBranches(const std::map<std::string, int>& branches, const std::string& currentBranch,
+                               int currentVersionId, int mergeVersionId) {
+    std::ostringstream file;
+    if (currentBranch.empty()) {
+        file << "DETACHED:" << currentVersionId << std::endl;
+    } else {
+        file << "CURRENT:" << currentBranch << std::endl;
+    }
+    if (mergeVersionId > 0) {
+        file << "MERGING:" << mergeVersionId << std::endl;
+    }
+    // The id goes first: it cannot contain ':', a branch name might
+    for (const auto& branch : branches) {
+        file << "BRANCH:" << branch.second << ":" << branch.first << std::endl;
+    }
+    
+    return writeFile(getBranchesFilePath(), file.str());
+}
+
+bool FileHandler::loadBranches(std::map<std::string, int>& branches, std::string& currentBranch,
+                               int& currentVersionId, int& mergeVersionId) {
+    std::ifstream file(getBranchesFilePath());
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    branches.clear();
+    currentBranch.clear();
+    currentVersionId = 0;
+    mergeVersionId = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.substr(0, 8) == "CURRENT:") {
+            currentBranch = line.substr(8);
+        } else if (line.substr(0, 9) == "DETACHED:") {
+            currentVersionId = std::stoi(line.substr(9));
+        } else if (line.substr(0, 8) == "MERGING:") {
+            mergeVersionId = std::stoi(line.substr(8));
+        } else if (line.substr(0, 7) == "BRANCH:") {
+            size_t colon = line.find(':', 7);
+            if (colon == std::string::npos) {
+                return false;
+            }
+            branches[line.substr(colon + 1)] = std::stoi(line.substr(7, colon - 7));
+        }
+    }
+    return true;
+}
+
 bool FileHandler::saveFileContent(const std::string& filename, const std::string& content) {
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -205,6 +643,10 @@ std::string FileHandler::loadFileContent(const std::string& filename) {
 }
 
 std::string FileHandler::getCommitFilePath(int versionId) {
+    return dataPath + "/commits/commit_" + std::to_string(versionId) + ".bin";
+}
+
+std::string FileHandler::getTextCommitFilePath(int versionId) {
     return dataPath + "/commits/commit_" + std::to_string(versionId) + ".txt";
 }
 
@@ -212,6 +654,34 @@ std::string FileHandler::getMetadataFilePath() {
     return dataPath + "/repo_metadata.txt";
 }
 
+std::string FileHandler::getBranchesFilePath() {
+    return dataPath + "/branches.txt";
+}
+
+std::string FileHandler::getCommitIndexPath() {
+    return dataPath + "/commits/index.bin";
+}
+
+std::string FileHandler::getCommitGraphPath() {
+    return dataPath + "/commits/graph.bin";
+}
+
+std::string FileHandler::getCommitPackPath() {
+    return dataPath + "/commits/pack.bin";
+}
+
+std::string FileHandler::getWorkingIndexPath() {
+    return dataPath + "/index.bin";
+}
+
+std::string FileHandler::getSearchIndexPath() {
+    return dataPath + "/search.bin";
+}
+
+std::string FileHandler::getJournalPath() {
+    return dataPath + "/journal.bin";
+}
+
 bool FileHandler::fileExists(const std::string& path) {
     std::ifstream file(path);
     return file.good();
@@ -2,13 +2,34 @@
 #define FILEHANDLER_H
 
 #include "Commit.h"
+#include "ObjectStore.h"
+#include "CommitIndex.h"
+#include "CommitPack.h"
+#include "CommitGraph.h"
+#include "SearchIndex.h"
+#include "WorkingIndex.h"
+#include "Journal.h"
 #include <vector>
 #include <string>
+#include <map>
 #include <fstream>
+#include <functional>
 
 class FileHandler {
+public:
+    // Finds an already loaded commit by id, or returns null
+    typedef std::function<const Commit*(int versionId)> CommitLookup;
+    
 private:
     std::string dataPath;
+    ObjectStore objectStore;    // Shared file contents under <dataPath>/objects
+    CommitIndex commitIndex;    // Commit list under <dataPath>/commits/index.bin
+    CommitPack commitPack;      // Packed history in <dataPath>/commits/pack.bin
+    CommitGraph commitGraph;    // Parents and generations in <dataPath>/commits/graph.bin
+    WorkingIndex workingIndex;  // Working tree state under <dataPath>/index.bin
+    SearchIndex searchIndex;    // Content search cache in <dataPath>/search.bin
+    Journal journal;            // Write-ahead journal in <dataPath>/journal.bin
+    std::vector<CommitIndexEntry> pendingIndexEntries;  // Indexed once their commit is on disk
     
 public:
     FileHandler();
@@ -17,6 +38,7 @@ public:
     
     // Path management
     void setDataPath(const std::string& path);
+    ObjectStore* getObjectStore();
     
     // Directory operations
     bool createDirectory(const std::string& path);
@@ -24,20 +46,73 @@ public:
     
     // Commit file operations
     bool saveCommit(Commit* commit);
-    Commit* loadCommit(int versionId);
-    std::vector<Commit*> loadAllCommits();
+    // Loaded commits are allocated in arena, their file trees in trees.
+    // previous, if given, is the commit most likely to share directories.
+    // Parents are returned by id for the caller to link: parentIds gets the
+    // ones the commit lists, or defaultParentId for a format that lists none.
+    // A commit saved as changes to its base is built on that base, taken
+    // from previous or findCommit; without it the commit does not load.
+    Commit* loadCommit(int versionId, Arena& arena, TreePool& trees, const Commit* previous = nullptr,
+                       std::vector<int>* parentIds = nullptr, int defaultParentId = -1,
+                       const CommitLookup& findCommit = CommitLookup());
+    // parentIds[i] are the parents of the i-th commit returned
+    std::vector<Commit*> loadAllCommits(Arena& arena, TreePool& trees, std::vector<std::vector<int>>& parentIds);
+    const CommitIndex& getCommitIndex() const;
+    // Every saved commit once loadAllCommits has run, and those saved since
+    const CommitGraph& getCommitGraph() const;
+    
+    // Move every loose commit file into the pack and delete it. packedCount
+    // is the number of commits the pack holds afterwards.
+    bool repackCommits(size_t& packedCount);
+    WorkingIndex* getWorkingIndex();
+    SearchIndex* getSearchIndex();
+    
+    // Journaled writes: everything written between beginTransaction and
+    // commitTransaction reaches disk together or not at all. Transactions
+    // committed inside a batch share one journal flush.
+    void beginTransaction();
+    bool commitTransaction();
+    void beginBatch();
+    bool endBatch();
+    bool recoverJournal();
     
     // Repository metadata
     bool saveRepositoryMetadata(int nextVersionId, bool initialized);
     bool loadRepositoryMetadata(int& nextVersionId, bool& initialized);
     
+    // Branch tips by version id (0 for a branch with no commits yet), in
+    // <dataPath>/branches.txt. currentBranch is empty while a commit is
+    // checked out directly; currentVersionId names that commit.
+    // mergeVersionId is the commit being merged in, or 0.
+    bool saveBranches(const std::map<std::string, int>& branches, const std::string& currentBranch,
+                      int currentVersionId, int mergeVersionId);
+    bool loadBranches(std::map<std::string, int>& branches, std::string& currentBranch, int& currentVersionId,
+                      int& mergeVersionId);
+    
     // File content operations
     bool saveFileContent(const std::string& filename, const std::string& content);
     std::string loadFileContent(const std::string& filename);
     
 private:
+    // Only reads the pack or the commit file, so it may run on several threads at once
+    Commit* loadBinaryCommit(int versionId, Arena& arena, TreePool& trees, const Commit* previous,
+                             std::vector<int>* parentIds, int defaultParentId, const CommitLookup& findCommit);
+    Commit* loadTextCommit(const std::string& filepath, Arena& arena, TreePool& trees);
+    bool writeCommitFile(int versionId, const std::string& encoded);
+    bool writeFile(const std::string& path, const std::string& data);
+    bool indexPendingCommits();
+    void syncCommitGraph(const std::vector<Commit*>& commits, const std::vector<std::vector<int>>& parentIds);
+    CommitIndexEntry makeIndexEntry(Commit* commit, uint32_t messageOffset, int parentId);
     std::string getCommitFilePath(int versionId);
+    std::string getTextCommitFilePath(int versionId);
     std::string getMetadataFilePath();
+    std::string getBranchesFilePath();
+    std::string getCommitIndexPath();
+    std::string getCommitGraphPath();
+    std::string getCommitPackPath();
+    std::string getWorkingIndexPath();
+    std::string getSearchIndexPath();
+    std::string getJournalPath();
     bool fileExists(const std::string& path);
 };
 
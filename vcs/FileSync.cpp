@@ -0,0 +1,196 @@
+#include "FileSync.h"
+#include "Trace.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+
+static bool writeAll(const std::string& path, const std::string& data, DWORD disposition, bool durable) {
+    TRACE_COUNT("fs.open", 1);
+    HANDLE file = CreateFileA(path.c_str(), disposition == OPEN_ALWAYS ? FILE_APPEND_DATA : GENERIC_WRITE,
+                              0, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    bool ok = true;
+    size_t written = 0;
+    while (ok && written < data.size()) {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(data.size() - written, 1u << 30));
+        DWORD count = 0;
+        ok = WriteFile(file, data.data() + written, chunk, &count, nullptr) != 0;
+        written += count;
+        TRACE_COUNT("fs.write", 1);
+    }
+    TRACE_COUNT("fs.bytes_written", written);
+    if (ok && durable) {
+        TRACE_SCOPE("fs.fsync");
+        ok = FlushFileBuffers(file) != 0;
+    }
+    CloseHandle(file);
+    return ok;
+}
+
+#else
+
+static bool writeAll(const std::string& path, const std::string& data, int flags, bool durable) {
+    TRACE_COUNT("fs.open", 1);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | flags, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    
+    bool ok = true;
+    size_t written = 0;
+    while (ok && written < data.size()) {
+        ssize_t count = ::write(fd, data.data() + written, data.size() - written);
+        if (count < 0) {
+            ok = (errno == EINTR);
+            continue;
+        }
+        written += static_cast<size_t>(count);
+        TRACE_COUNT("fs.write", 1);
+    }
+    TRACE_COUNT("fs.bytes_written", written);
+    if (ok && durable) {
+        TRACE_SCOPE("fs.fsync");
+        ok = fsync(fd) == 0;
+    }
+    return ::close(fd) == 0 && ok;
+}
+
+#endif
+
+bool FileSync::replaceFile(const std::string& path, const std::string& data, bool durable) {
+    std::string tempPath = path + ".tmp";
+    
+#ifdef _WIN32
+    if (!writeAll(tempPath, data, CREATE_ALWAYS, durable)) {
+        DeleteFileA(tempPath.c_str());
+        return false;
+    }
+    TRACE_COUNT("fs.rename", 1);
+    // Write-through makes the rename itself durable
+    DWORD flags = MOVEFILE_REPLACE_EXISTING | (durable ? MOVEFILE_WRITE_THROUGH : 0);
+    if (!MoveFileExA(tempPath.c_str(), path.c_str(), flags)) {
+        DeleteFileA(tempPath.c_str());
+        return false;
+    }
+    return true;
+#else
+    if (!writeAll(tempPath, data, O_TRUNC, durable)) {
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    TRACE_COUNT("fs.rename", 1);
+    if (::rename(tempPath.c_str(), path.c_str()) != 0) {
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    return !durable || syncDirectory(parentDirectory(path));
+#endif
+}
+
+bool FileSync::appendFile(const std::string& path, const std::string& data, bool durable) {
+#ifdef _WIN32
+    return writeAll(path, data, OPEN_ALWAYS, durable);
+#else
+    return writeAll(path, data, O_APPEND, durable);
+#endif
+}
+
+bool FileSync::syncFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    TRACE_SCOPE("fs.fsync");
+    bool ok = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return ok;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    TRACE_SCOPE("fs.fsync");
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+bool FileSync::syncDirectory(const std::string& path) {
+#ifdef _WIN32
+    // NTFS journals directory changes itself; there is no handle to flush
+    (void)path;
+    return true;
+#else
+    int fd = ::open(path.empty() ? "." : path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    TRACE_SCOPE("fs.fsync");
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+bool FileSync::syncFileSystem(const std::string& path) {
+#ifdef __linux__
+    int fd = ::open(path.empty() ? "." : path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    TRACE_SCOPE("fs.syncfs");
+    bool ok = syncfs(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+bool FileSync::createParentDirectories(const std::string& path) {
+    std::string parent = parentDirectory(path);
+    for (size_t pos = parent.find('/', 1); ; pos = parent.find('/', pos + 1)) {
+        std::string directory = parent.substr(0, pos);
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+        if (pos == std::string::npos) {
+            break;
+        }
+    }
+    
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(parent.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat info;
+    return stat(parent.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+std::string FileSync::parentDirectory(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
\ No newline at end of file
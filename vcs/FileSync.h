@@ -0,0 +1,31 @@
+#ifndef FILESYNC_H
+#define FILESYNC_H
+
+#include <string>
+
+// Whole-file writes that never leave a torn file behind, and the flushes
+// that make them survive a crash or power loss.
+class FileSync {
+public:
+    // Write data to "<path>.tmp" and rename it over path, so readers see
+    // either the old file or the new one. When durable, the data is flushed
+    // before the rename and the directory entry after it.
+    static bool replaceFile(const std::string& path, const std::string& data, bool durable);
+    
+    // Append data to path, creating it if needed; flush it when durable
+    static bool appendFile(const std::string& path, const std::string& data, bool durable);
+    
+    // Flush a file's data, or a directory's entries, to stable storage
+    static bool syncFile(const std::string& path);
+    static bool syncDirectory(const std::string& path);
+    
+    // Flush everything written under path in one call where the platform
+    // allows it; returns false if each file has to be synced on its own
+    static bool syncFileSystem(const std::string& path);
+    
+    // Create every missing directory leading up to path's last component
+    static bool createParentDirectories(const std::string& path);
+    static std::string parentDirectory(const std::string& path);
+};
+
+#endif
\ No newline at end of file
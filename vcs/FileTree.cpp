@@ -0,0 +1,200 @@
+#include "FileTree.h"
+#include <algorithm>
+
+static bool sameFile(const FileEntry& a, const FileEntry& b) {
+    return a.size == b.size && a.blobId == b.blobId;
+}
+
+// Binary search one directory for a name
+static const TreeEntry* findEntry(const TreeNode* node, std::string_view name, bool isDirectory) {
+    const TreeEntry* first = node->entries;
+    const TreeEntry* last = node->entries + node->entryCount;
+    const TreeEntry* it = std::lower_bound(first, last, name, [isDirectory](const TreeEntry& entry, std::string_view key) {
+        return FileTree::compareNames(entry.name, entry.subtree != nullptr, key, isDirectory) < 0;
+    });
+    if (it != last && it->name == name && (it->subtree != nullptr) == isDirectory) {
+        return it;
+    }
+    return nullptr;
+}
+
+static void compareNodes(const TreeNode* before, const TreeNode* after, std::string& path,
+                         const FileTree::ChangeVisitor& visit);
+
+// One name present on either or both sides; both sides are the same kind
+static void compareEntries(const TreeEntry* before, const TreeEntry* after, std::string& path,
+                           const FileTree::ChangeVisitor& visit) {
+    size_t length = path.size();
+    path += (before ? before->name : after->name);
+    
+    if ((before && before->subtree) || (after && after->subtree)) {
+        path += '/';
+        compareNodes(before ? before->subtree : nullptr, after ? after->subtree : nullptr, path, visit);
+    } else if (!before || !after || !sameFile(before->file, after->file)) {
+        visit(path, before ? &before->file : nullptr, after ? &after->file : nullptr);
+    }
+    path.resize(length);
+}
+
+static void compareNodes(const TreeNode* before, const TreeNode* after, std::string& path,
+                         const FileTree::ChangeVisitor& visit) {
+    // Hash-consing makes equal subtrees the same node
+    if (before == after) {
+        return;
+    }
+    
+    uint32_t beforeCount = before ? before->entryCount : 0;
+    uint32_t afterCount = after ? after->entryCount : 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+    while (i < beforeCount || j < afterCount) {
+        int order;
+        if (i == beforeCount) {
+            order = 1;
+        } else if (j == afterCount) {
+            order = -1;
+        } else {
+            const TreeEntry& a = before->entries[i];
+            const TreeEntry& b = after->entries[j];
+            order = FileTree::compareNames(a.name, a.subtree != nullptr, b.name, b.subtree != nullptr);
+        }
+        
+        if (order < 0) {
+            compareEntries(&before->entries[i++], nullptr, path, visit);
+        } else if (order > 0) {
+            compareEntries(nullptr, &after->entries[j++], path, visit);
+        } else {
+            compareEntries(&before->entries[i++], &after->entries[j++], path, visit);
+        }
+    }
+}
+
+
+FileTree::const_iterator::const_iterator() {
+}
+
+FileTree::const_iterator::const_iterator(const TreeNode* root) {
+    if (root) {
+        Level level = { root, 0, 0 };
+        stack.push_back(level);
+        settle();
+    }
+}
+
+FileTree::value_type FileTree::const_iterator::operator*() const {
+    const Level& level = stack.back();
+    return value_type(path, level.node->entries[level.index].file);
+}
+
+FileTree::const_iterator& FileTree::const_iterator::operator++() {
+    stack.back().index++;
+    settle();
+    return *this;
+}
+
+bool FileTree::const_iterator::operator==(const const_iterator& other) const {
+    if (stack.size() != other.stack.size()) {
+        return false;
+    }
+    return stack.empty() ||
+           (stack.back().node == other.stack.back().node && stack.back().index == other.stack.back().index);
+}
+
+bool FileTree::const_iterator::operator!=(const const_iterator& other) const {
+    return !(*this == other);
+}
+
+void FileTree::const_iterator::settle() {
+    // Move to the next file at or after the current position, depth first
+    while (!stack.empty()) {
+        Level& level = stack.back();
+        if (level.index >= level.node->entryCount) {
+            stack.pop_back();
+            if (!stack.empty()) {
+                stack.back().index++;
+            }
+            continue;
+        }
+        
+        const TreeEntry& entry = level.node->entries[level.index];
+        path.resize(level.pathLength);
+        path += entry.name;
+        if (!entry.subtree) {
+            return;
+        }
+        path += '/';
+        Level child = { entry.subtree, 0, path.size() };
+        stack.push_back(child);
+    }
+}
+
+
+FileTree::FileTree() : root(nullptr) {
+}
+
+FileTree::FileTree(const TreeNode* rootNode) : root(rootNode) {
+}
+
+const TreeNode* FileTree::getRoot() const {
+    return root;
+}
+
+FileTree::const_iterator FileTree::begin() const {
+    return const_iterator(root);
+}
+
+FileTree::const_iterator FileTree::end() const {
+    return const_iterator();
+}
+
+size_t FileTree::size() const {
+    return root ? root->fileCount : 0;
+}
+
+bool FileTree::empty() const {
+    return !root;
+}
+
+const FileEntry* FileTree::find(std::string_view path) const {
+    const TreeNode* node = root;
+    size_t start = 0;
+    while (node) {
+        size_t slash = path.find('/', start);
+        bool isDirectory = (slash != std::string_view::npos);
+        std::string_view name = path.substr(start, isDirectory ? slash - start : std::string_view::npos);
+        
+        const TreeEntry* entry = findEntry(node, name, isDirectory);
+        if (!entry) {
+            return nullptr;
+        }
+        if (!isDirectory) {
+            return &entry->file;
+        }
+        node = entry->subtree;
+        start = slash + 1;
+    }
+    return nullptr;
+}
+
+void FileTree::compare(const FileTree& before, const FileTree& after, const ChangeVisitor& visit) {
+    std::string path;
+    compareNodes(before.root, after.root, path, visit);
+}
+
+int FileTree::compareNames(std::string_view a, bool aIsDirectory, std::string_view b, bool bIsDirectory) {
+    size_t common = std::min(a.size(), b.size());
+    int order = a.substr(0, common).compare(b.substr(0, common));
+    if (order != 0) {
+        return order;
+    }
+    
+    // One name is a prefix of the other. What follows it is '/' for a
+    // directory and the end for a file; names never contain '/'.
+    if (a.size() == b.size()) {
+        return (aIsDirectory == bIsDirectory) ? 0 : (aIsDirectory ? 1 : -1);
+    }
+    if (a.size() < b.size()) {
+        return (aIsDirectory && static_cast<unsigned char>(b[common]) < '/') ? 1 : -1;
+    }
+    return (bIsDirectory && static_cast<unsigned char>(a[common]) < '/') ? -1 : 1;
+}
\ No newline at end of file
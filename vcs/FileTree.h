@@ -0,0 +1,102 @@
+#ifndef FILETREE_H
+#define FILETREE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// A file as recorded in a commit: a reference into the object store
+struct FileEntry {
+    std::string_view blobId;    // SHA-1 of the content, interned
+    size_t size;                // Content length in bytes
+};
+
+struct TreeNode;
+
+// One name in a directory: a file, or a subdirectory when subtree is set
+struct TreeEntry {
+    std::string_view name;      // Path component, interned
+    const TreeNode* subtree;
+    FileEntry file;             // Only for files
+};
+
+// A directory. Nodes are immutable and hash-consed by TreePool, so two
+// directories with the same contents are the same node wherever they
+// appear, and comparing subtrees is a pointer comparison. Entries are
+// sorted as their full paths sort: a directory's name compares as if it
+// ended in '/'.
+struct TreeNode {
+    size_t hash;
+    size_t fileCount;           // Files in this directory and all below it
+    uint32_t entryCount;
+    const TreeEntry* entries;
+};
+
+// A change to apply to a tree: set path to file, or remove it
+struct TreeEdit {
+    std::string_view path;
+    FileEntry file;
+    bool remove;
+};
+
+// A commit's files: a handle to the root of a shared tree. Paths are split
+// on '/'. Iteration visits files in path order, building each path as it
+// goes, so the path a step yields is only valid until the next step.
+class FileTree {
+public:
+    typedef std::pair<std::string_view, FileEntry> value_type;
+    
+    // Called for each path whose entry differs; a side without the file is null
+    typedef std::function<void(std::string_view path, const FileEntry* before,
+                               const FileEntry* after)> ChangeVisitor;
+    
+    class const_iterator {
+    private:
+        struct Level {
+            const TreeNode* node;
+            uint32_t index;
+            size_t pathLength;  // Length of path up to this directory
+        };
+        std::vector<Level> stack;
+        std::string path;
+    
+    public:
+        const_iterator();
+        explicit const_iterator(const TreeNode* root);
+        
+        value_type operator*() const;
+        const_iterator& operator++();
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+    
+    private:
+        void settle();
+    };
+
+private:
+    const TreeNode* root;       // Null for an empty tree
+
+public:
+    FileTree();
+    explicit FileTree(const TreeNode* rootNode);
+    
+    const TreeNode* getRoot() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const;
+    bool empty() const;
+    const FileEntry* find(std::string_view path) const;
+    
+    // Visit added, removed and changed files in path order. Subtrees that
+    // are the same node on both sides are skipped without being entered.
+    static void compare(const FileTree& before, const FileTree& after, const ChangeVisitor& visit);
+    
+    // Sort order of entries within a directory
+    static int compareNames(std::string_view a, bool aIsDirectory, std::string_view b, bool bIsDirectory);
+};
+
+#endif
\ No newline at end of file
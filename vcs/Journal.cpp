@@ -0,0 +1,295 @@
+#include "Journal.h"
+#include "Trace.h"
+#include "FileSync.h"
+#include "BinaryIO.h"
+#include "MappedFile.h"
+#include <sys/stat.h>
+#include <array>
+
+// File layout: magic "MVCJ" and format version, then one record per
+// transaction: payload length, write count, CRC-32 of the payload, and the
+// payload itself, holding per write the path length, data length, path
+// (relative to the data folder) and data. A record cut short by a crash,
+// or one whose checksum does not match, ends the journal.
+static const char JOURNAL_MAGIC[4] = { 'M', 'V', 'C', 'J' };
+static const uint32_t JOURNAL_VERSION = 1;
+static const size_t JOURNAL_HEADER_SIZE = 8;
+static const size_t RECORD_HEADER_SIZE = 16;
+static const size_t WRITE_HEADER_SIZE = 12;
+
+// Checkpoint once the journal holds this much, so replay stays short
+static const uint64_t CHECKPOINT_SIZE = 64ull << 20;
+
+// Flush a batch early once it has staged this much
+static const size_t MAX_UNFLUSHED_SIZE = 64u << 20;
+
+static std::string makeJournalHeader() {
+    std::string header(JOURNAL_MAGIC, 4);
+    appendU32(header, JOURNAL_VERSION);
+    return header;
+}
+
+Journal::Journal() : openWrites(0), journalSize(0), transactionDepth(0), batchDepth(0) {
+}
+
+Journal::~Journal() {
+    // Sealed transactions were reported as committed; get them to disk
+    flush();
+}
+
+void Journal::setPaths(const std::string& path, const std::string& root) {
+    flush();
+    journalPath = path;
+    rootPath = root;
+    staged.clear();
+    stagedSlots.clear();
+    openPayload.clear();
+    openWrites = 0;
+    unflushed.clear();
+    unsynced.clear();
+    transactionDepth = 0;
+    batchDepth = 0;
+    
+    struct stat info;
+    journalSize = (stat(journalPath.c_str(), &info) == 0) ? static_cast<uint64_t>(info.st_size) : 0;
+}
+
+void Journal::begin() {
+    transactionDepth++;
+}
+
+bool Journal::commit() {
+    if (transactionDepth == 0) {
+        return false;
+    }
+    if (--transactionDepth > 0) {
+        return true;
+    }
+    
+    seal();
+    if (batchDepth > 0 && unflushed.size() < MAX_UNFLUSHED_SIZE) {
+        return true;
+    }
+    return flush();
+}
+
+bool Journal::isOpen() const {
+    return transactionDepth > 0;
+}
+
+void Journal::beginBatch() {
+    batchDepth++;
+}
+
+bool Journal::endBatch() {
+    if (batchDepth == 0) {
+        return false;
+    }
+    if (--batchDepth > 0) {
+        return true;
+    }
+    return flush();
+}
+
+bool Journal::write(const std::string& path, const std::string& data) {
+    if (transactionDepth == 0 || path.compare(0, rootPath.size() + 1, rootPath + "/") != 0) {
+        return false;
+    }
+    
+    std::string relative = toRelative(path);
+    appendU32(openPayload, static_cast<uint32_t>(relative.size()));
+    appendU64(openPayload, data.size());
+    openPayload += relative;
+    openPayload += data;
+    openWrites++;
+    
+    // A later write of the same path replaces the staged data
+    auto it = stagedSlots.find(path);
+    if (it != stagedSlots.end()) {
+        staged[it->second].second = data;
+    } else {
+        stagedSlots[path] = staged.size();
+        staged.push_back(std::make_pair(path, data));
+    }
+    return true;
+}
+
+const std::string* Journal::findStaged(const std::string& path) const {
+    auto it = stagedSlots.find(path);
+    if (it != stagedSlots.end()) {
+        return &staged[it->second].second;
+    }
+    return nullptr;
+}
+
+bool Journal::flush() {
+    // Staged writes of an open transaction must not be applied yet; its
+    // commit flushes everything
+    if (unflushed.empty() || transactionDepth > 0) {
+        return true;
+    }
+    TRACE_SCOPE("journal.flush");
+    TRACE_COUNT("journal.bytes_written", unflushed.size());
+    
+    // The journal header is written once, atomically
+    if (journalSize < JOURNAL_HEADER_SIZE) {
+        if (!FileSync::replaceFile(journalPath, makeJournalHeader(), true)) {
+            return false;
+        }
+        journalSize = JOURNAL_HEADER_SIZE;
+    }
+    
+    // The one fsync every sealed transaction shares
+    if (!FileSync::appendFile(journalPath, unflushed, true)) {
+        return false;
+    }
+    journalSize += unflushed.size();
+    unflushed.clear();
+    
+    bool ok = apply();
+    if (journalSize >= CHECKPOINT_SIZE) {
+        ok = checkpoint() && ok;
+    }
+    return ok;
+}
+
+bool Journal::hasUnflushed() const {
+    return !unflushed.empty();
+}
+
+bool Journal::recover() {
+    MappedFile file;
+    if (!file.open(journalPath)) {
+        journalSize = 0;
+        return true; // No journal, nothing to replay
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    size_t pos = JOURNAL_HEADER_SIZE;
+    if (size < JOURNAL_HEADER_SIZE || data[0] != JOURNAL_MAGIC[0] || data[1] != JOURNAL_MAGIC[1] ||
+        data[2] != JOURNAL_MAGIC[2] || data[3] != JOURNAL_MAGIC[3] || readU32(data + 4) > JOURNAL_VERSION) {
+        pos = size; // Unreadable; nothing in it can be trusted
+    }
+    
+    bool ok = true;
+    while (size - pos >= RECORD_HEADER_SIZE) {
+        uint64_t payloadSize = readU64(data + pos);
+        uint32_t writeCount = readU32(data + pos + 8);
+        const char* payload = data + pos + RECORD_HEADER_SIZE;
+        if (payloadSize > size - pos - RECORD_HEADER_SIZE ||
+            checksum(payload, static_cast<size_t>(payloadSize)) != readU32(data + pos + 12)) {
+            break; // Torn tail
+        }
+        
+        size_t offset = 0;
+        for (uint32_t i = 0; i < writeCount && payloadSize - offset >= WRITE_HEADER_SIZE; i++) {
+            size_t pathSize = readU32(payload + offset);
+            uint64_t dataSize = readU64(payload + offset + 4);
+            offset += WRITE_HEADER_SIZE;
+            if (pathSize > payloadSize - offset || dataSize > payloadSize - offset - pathSize) {
+                break;
+            }
+            std::string path = toFull(std::string(payload + offset, pathSize));
+            offset += pathSize;
+            ok = applyFile(path, std::string(payload + offset, static_cast<size_t>(dataSize))) && ok;
+            offset += static_cast<size_t>(dataSize);
+        }
+        pos += RECORD_HEADER_SIZE + static_cast<size_t>(payloadSize);
+    }
+    
+    file.close();
+    journalSize = size;
+    
+    // Keep the journal if replay failed, so the next load tries again
+    return ok && checkpoint();
+}
+
+bool Journal::checkpoint() {
+    if (journalSize <= JOURNAL_HEADER_SIZE && unsynced.empty()) {
+        return true;
+    }
+    
+    // Applied files must be durable before the records covering them go
+    bool ok = FileSync::syncFileSystem(rootPath);
+    if (!ok) {
+        ok = true;
+        std::unordered_set<std::string> directories;
+        for (const std::string& path : unsynced) {
+            ok = FileSync::syncFile(path) && ok;
+            directories.insert(FileSync::parentDirectory(path));
+        }
+        for (const std::string& directory : directories) {
+            ok = FileSync::syncDirectory(directory) && ok;
+        }
+    }
+    if (!ok || !FileSync::replaceFile(journalPath, makeJournalHeader(), true)) {
+        return false;
+    }
+    
+    journalSize = JOURNAL_HEADER_SIZE;
+    unsynced.clear();
+    return true;
+}
+
+uint32_t Journal::checksum(const char* data, size_t size) {
+    // CRC-32 (IEEE), table built once on first use; the static initializer
+    // is thread-safe
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> values;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+            }
+            values[i] = value;
+        }
+        return values;
+    }();
+    
+    uint32_t crc = 0xFFFFFFFFu;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void Journal::seal() {
+    if (openWrites > 0) {
+        appendU64(unflushed, openPayload.size());
+        appendU32(unflushed, openWrites);
+        appendU32(unflushed, checksum(openPayload.data(), openPayload.size()));
+        unflushed += openPayload;
+    }
+    openPayload.clear();
+    openWrites = 0;
+}
+
+bool Journal::apply() {
+    bool ok = true;
+    for (const auto& write : staged) {
+        ok = applyFile(write.first, write.second) && ok;
+    }
+    staged.clear();
+    stagedSlots.clear();
+    return ok;
+}
+
+bool Journal::applyFile(const std::string& path, const std::string& data) {
+    // Directories made before a crash may not have survived it
+    if (!FileSync::replaceFile(path, data, false) &&
+        !(FileSync::createParentDirectories(path) && FileSync::replaceFile(path, data, false))) {
+        return false;
+    }
+    unsynced.insert(path);
+    return true;
+}
+
+std::string Journal::toRelative(const std::string& path) const {
+    return path.substr(rootPath.size() + 1);
+}
+
+std::string Journal::toFull(const std::string& relative) const {
+    return rootPath + "/" + relative;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+
+// Write-ahead journal kept in <dataPath>/journal.bin. The file writes of a
+// transaction (objects, the commit file, metadata) are staged in memory,
+// appended to the journal as one checksummed record and flushed with a
+// single fsync; only then are they written to their real paths. After a
+// crash, recover() replays every complete record, so a commit is either
+// fully on disk or not at all.
+//
+// Inside a batch, transactions are sealed but not flushed; the whole batch
+// shares one journal write and one fsync when the batch ends. Applied
+// files are not synced one by one; a checkpoint syncs them together once
+// the journal grows past its limit, and then empties the journal.
+class Journal {
+private:
+    std::string journalPath;
+    std::string rootPath;   // Journal records hold paths relative to this
+    std::vector<std::pair<std::string, std::string>> staged;   // path -> data, not yet applied
+    std::unordered_map<std::string, size_t> stagedSlots;        // path -> staged slot
+    std::string openPayload;    // Encoded writes of the open transaction
+    uint32_t openWrites;
+    std::string unflushed;  // Sealed transaction records not yet in the journal
+    std::unordered_set<std::string> unsynced;   // Applied since the last checkpoint
+    uint64_t journalSize;
+    int transactionDepth;
+    int batchDepth;
+
+public:
+    Journal();
+    ~Journal();
+    
+    void setPaths(const std::string& path, const std::string& root);
+    
+    // Transactions nest; the outermost commit seals them as one record
+    void begin();
+    bool commit();
+    bool isOpen() const;
+    
+    // Group commit: transactions sealed inside a batch share one flush
+    void beginBatch();
+    bool endBatch();
+    
+    // Stage a whole-file write; false when no transaction is open or the
+    // path lies outside the journal's root
+    bool write(const std::string& path, const std::string& data);
+    
+    // Data staged for path but not yet written there, or null
+    const std::string* findStaged(const std::string& path) const;
+    
+    // Write sealed records to the journal, sync it, then apply them
+    bool flush();
+    bool hasUnflushed() const;
+    
+    // Replay complete records left by a crash, then checkpoint
+    bool recover();
+    
+    // Sync every applied file and empty the journal
+    bool checkpoint();
+    
+    static uint32_t checksum(const char* data, size_t size);
+
+private:
+    void seal();
+    bool apply();
+    bool applyFile(const std::string& path, const std::string& data);
+    std::string toRelative(const std::string& path) const;
+    std::string toFull(const std::string& relative) const;
+};
+
+#endif
\ No newline at end of file
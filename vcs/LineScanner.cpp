@@ -0,0 +1,280 @@
+#include "LineScanner.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LINESCANNER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LINESCANNER_AVX2_TARGET __attribute__((target("avx2")))
+#define LINESCANNER_SSE2_TARGET __attribute__((target("sse2")))
+#else
+#define LINESCANNER_AVX2_TARGET
+#define LINESCANNER_SSE2_TARGET
+#endif
+
+// Each kernel calls emit(position) for every newline in [0, size)
+typedef void (*NewlineVisitor)(size_t position, void* state);
+typedef void (*ScanKernel)(const char* data, size_t size, NewlineVisitor visit, void* state);
+typedef size_t (*CountKernel)(const char* data, size_t size);
+
+static inline int popcount32(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(value);
+#else
+    int count = 0;
+    while (value) {
+        value &= value - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+static inline int lowestBit(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    while (!(value & 1)) {
+        value >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Scalar kernels
+// ---------------------------------------------------------------------------
+
+static void scanScalar(const char* data, size_t size, NewlineVisitor visit, void* state) {
+    const char* cursor = data;
+    const char* end = data + size;
+    while (cursor < end) {
+        const void* found = memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+        if (!found) {
+            break;
+        }
+        const char* newline = static_cast<const char*>(found);
+        visit(static_cast<size_t>(newline - data), state);
+        cursor = newline + 1;
+    }
+}
+
+static size_t countScalar(const char* data, size_t size) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; i++) {
+        count += (data[i] == '\n');
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// SSE2 / AVX2 kernels: compare 16 or 32 bytes at once and walk the bitmask
+// ---------------------------------------------------------------------------
+
+#ifdef LINESCANNER_X86
+
+LINESCANNER_SSE2_TARGET
+static void scanSse2(const char* data, size_t size, NewlineVisitor visit, void* state) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        while (mask) {
+            visit(i + lowestBit(mask), state);
+            mask &= mask - 1;
+        }
+    }
+    for (; i < size; i++) {
+        if (data[i] == '\n') {
+            visit(i, state);
+        }
+    }
+}
+
+LINESCANNER_SSE2_TARGET
+static size_t countSse2(const char* data, size_t size) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        count += popcount32(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline))));
+    }
+    return count + countScalar(data + i, size - i);
+}
+
+LINESCANNER_AVX2_TARGET
+static void scanAvx2(const char* data, size_t size, NewlineVisitor visit, void* state) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        while (mask) {
+            visit(i + lowestBit(mask), state);
+            mask &= mask - 1;
+        }
+    }
+    for (; i < size; i++) {
+        if (data[i] == '\n') {
+            visit(i, state);
+        }
+    }
+}
+
+LINESCANNER_AVX2_TARGET
+static size_t countAvx2(const char* data, size_t size) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        count += popcount32(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline))));
+    }
+    return count + countScalar(data + i, size - i);
+}
+
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static bool cpuHasSse2() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;    // Part of the x86-64 baseline
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+struct Kernels {
+    ScanKernel scan;
+    CountKernel count;
+    const char* name;
+};
+
+static Kernels selectKernels() {
+#ifdef LINESCANNER_X86
+    if (cpuHasAvx2()) {
+        return Kernels{ scanAvx2, countAvx2, "avx2" };
+    }
+    if (cpuHasSse2()) {
+        return Kernels{ scanSse2, countSse2, "sse2" };
+    }
+#endif
+    return Kernels{ scanScalar, countScalar, "scalar" };
+}
+
+static const Kernels& kernels() {
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+
+struct SplitState {
+    const char* data;
+    size_t lineStart;
+    std::vector<std::string_view>* lines;
+};
+
+static void collectLine(size_t position, void* state) {
+    SplitState* split = static_cast<SplitState*>(state);
+    split->lines->emplace_back(split->data + split->lineStart, position + 1 - split->lineStart);
+    split->lineStart = position + 1;
+}
+
+size_t LineScanner::countNewlines(const char* data, size_t size) {
+    return kernels().count(data, size);
+}
+
+size_t LineScanner::countNewlines(const std::string& text) {
+    return countNewlines(text.data(), text.size());
+}
+
+void LineScanner::splitLines(const char* data, size_t size, std::vector<std::string_view>& lines) {
+    lines.clear();
+    SplitState state = { data, 0, &lines };
+    kernels().scan(data, size, collectLine, &state);
+    if (state.lineStart < size) {
+        lines.emplace_back(data + state.lineStart, size - state.lineStart);
+    }
+}
+
+void LineScanner::splitLines(const std::string& text, std::vector<std::string_view>& lines) {
+    splitLines(text.data(), text.size(), lines);
+}
+
+uint64_t LineScanner::hashLine(const char* data, size_t size) {
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash = 0xCBF29CE484222325ULL ^ (size * multiplier);
+    
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 29;
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        memcpy(&word, data + i, size - i);
+        hash = (hash ^ word) * multiplier;
+    }
+    
+    // Final avalanche so that low bits are usable as bucket indices
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+void LineScanner::hashLines(const std::vector<std::string_view>& lines, std::vector<uint64_t>& hashes) {
+    hashes.resize(lines.size());
+    for (size_t i = 0; i < lines.size(); i++) {
+        hashes[i] = hashLine(lines[i].data(), lines[i].size());
+    }
+}
+
+const char* LineScanner::getKernelName() {
+    return kernels().name;
+}
\ No newline at end of file
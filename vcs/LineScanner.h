@@ -0,0 +1,38 @@
+#ifndef LINESCANNER_H
+#define LINESCANNER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Newline scanning and line hashing used wherever file content is split
+// into lines. On x86 the scan uses AVX2 or SSE2, picked once at runtime
+// from what the CPU supports; other targets use the portable scalar loop.
+class LineScanner {
+public:
+    // Number of '\n' characters in data
+    static size_t countNewlines(const char* data, size_t size);
+    static size_t countNewlines(const std::string& text);
+    
+    // Split into lines; each view keeps its trailing '\n' (the last line may lack one)
+    static void splitLines(const char* data, size_t size, std::vector<std::string_view>& lines);
+    static void splitLines(const std::string& text, std::vector<std::string_view>& lines);
+    
+    // 64-bit hash of a line, consuming eight bytes per step
+    static uint64_t hashLine(const char* data, size_t size);
+    static void hashLines(const std::vector<std::string_view>& lines, std::vector<uint64_t>& hashes);
+    
+    // Name of the kernel in use: "avx2", "sse2" or "scalar"
+    static const char* getKernelName();
+};
+
+// Hasher for containers keyed by line views
+struct LineHash {
+    size_t operator()(std::string_view line) const {
+        return static_cast<size_t>(LineScanner::hashLine(line.data(), line.size()));
+    }
+};
+
+#endif
\ No newline at end of file
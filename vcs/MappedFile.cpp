@@ -0,0 +1,151 @@
+#include "MappedFile.h"
+#include "Trace.h"
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : view(nullptr), length(0)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#else
+    , mapped(false)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    TRACE_COUNT("fs.open", 1);
+    
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    
+    // Empty files cannot be mapped
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        view = fallback.data();
+        return true;
+    }
+    
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return readWhole(path);
+    }
+    
+    view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return readWhole(path);
+    }
+    
+    fileHandle = file;
+    mappingHandle = mapping;
+    length = static_cast<size_t>(fileSize.QuadPart);
+    TRACE_COUNT("fs.bytes_mapped", length);
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    if (info.st_size == 0) {
+        ::close(fd);
+        view = fallback.data();
+        return true;
+    }
+    
+    void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        return readWhole(path);
+    }
+    
+    view = static_cast<const char*>(address);
+    length = static_cast<size_t>(info.st_size);
+    mapped = true;
+    TRACE_COUNT("fs.bytes_mapped", length);
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (mappingHandle) {
+        UnmapViewOfFile(view);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+    }
+#else
+    if (mapped) {
+        munmap(const_cast<char*>(view), length);
+        mapped = false;
+    }
+#endif
+    fallback.clear();
+    view = nullptr;
+    length = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return view != nullptr;
+}
+
+const char* MappedFile::data() const {
+    return view;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+bool MappedFile::readWhole(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    fallback.resize(static_cast<size_t>(size));
+    if (size > 0 && !file.read(&fallback[0], size)) {
+        fallback.clear();
+        return false;
+    }
+    
+    view = fallback.data();
+    length = fallback.size();
+    TRACE_COUNT("fs.bytes_read", length);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only view of a whole file. The file is memory-mapped where possible,
+// otherwise it is pulled into memory with a single bulk read.
+class MappedFile {
+private:
+    const char* view;
+    size_t length;
+    std::string fallback;   // Owns the bytes when mapping is not used
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    bool mapped;
+#endif
+    
+public:
+    MappedFile();
+    ~MappedFile();
+    
+    bool open(const std::string& path);
+    void close();
+    
+    bool isOpen() const;
+    const char* data() const;
+    size_t size() const;
+    
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+    bool readWhole(const std::string& path);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "Merge.h"
+#include "Diff.h"
+#include "ObjectStore.h"
+#include <unordered_map>
+#include <queue>
+
+Commit* Merge::findMergeBase(Commit* a, Commit* b) {
+    if (!a || !b) {
+        return nullptr;
+    }
+    if (a == b) {
+        return a;
+    }
+    
+    // A parent's generation is always below its children's, so by the time
+    // a commit is taken every path to it from a and b has been followed,
+    // and the first commit reached from both is the newest common ancestor
+    const int FROM_A = 1;
+    const int FROM_B = 2;
+    auto older = [](const Commit* x, const Commit* y) {
+        return x->generation < y->generation ||
+               (x->generation == y->generation && x->versionId < y->versionId);
+    };
+    std::priority_queue<Commit*, std::vector<Commit*>, decltype(older)> pending(older);
+    std::unordered_map<const Commit*, int> reached;
+    reached[a] = FROM_A;
+    reached[b] = FROM_B;
+    pending.push(a);
+    pending.push(b);
+    
+    while (!pending.empty()) {
+        Commit* commit = pending.top();
+        pending.pop();
+        int from = reached[commit];
+        if (from == (FROM_A | FROM_B)) {
+            return commit;
+        }
+        
+        for (uint32_t i = 0; i < commit->parentCount; i++) {
+            Commit* parent = commit->parents[i];
+            int& parentFrom = reached[parent];
+            if ((parentFrom | from) != parentFrom) {
+                if (parentFrom == 0) {
+                    pending.push(parent);
+                }
+                parentFrom |= from;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// One side's change to a path since the base
+struct SideChange {
+    bool present;           // False if the side removed the file
+    FileEntry file;
+};
+
+static bool sameChange(const SideChange& ours, const FileEntry* theirs) {
+    if (!ours.present || !theirs) {
+        return !ours.present && !theirs;
+    }
+    return ours.file.blobId == theirs->blobId;
+}
+
+static MergedFile takeFile(std::string_view path, const FileEntry* file) {
+    MergedFile merged;
+    merged.path.assign(path.data(), path.size());
+    merged.remove = (file == nullptr);
+    merged.conflict = false;
+    merged.size = 0;
+    if (file) {
+        merged.blobId.assign(file->blobId.data(), file->blobId.size());
+        merged.size = file->size;
+    }
+    return merged;
+}
+
+std::vector<MergedFile> Merge::mergeTrees(const FileTree& base, const FileTree& ours, const FileTree& theirs,
+                                          ObjectStore* store, const std::string& oursLabel,
+                                          const std::string& theirsLabel) {
+    std::unordered_map<std::string, SideChange> ourChanges;
+    FileTree::compare(base, ours, [&](std::string_view path, const FileEntry*, const FileEntry* after) {
+        SideChange change = { after != nullptr, after ? *after : FileEntry() };
+        ourChanges[std::string(path)] = change;
+    });
+    
+    std::vector<MergedFile> merged;
+    FileTree::compare(base, theirs, [&](std::string_view path, const FileEntry* before, const FileEntry* after) {
+        auto ourChange = ourChanges.find(std::string(path));
+        if (ourChange == ourChanges.end()) {
+            // Only their side changed it
+            merged.push_back(takeFile(path, after));
+            return;
+        }
+        const SideChange& ourSide = ourChange->second;
+        if (sameChange(ourSide, after)) {
+            return;
+        }
+        
+        // Removed on one side and changed on the other: keep the changed file
+        if (!ourSide.present || !after) {
+            MergedFile file = takeFile(path, after ? after : &ourSide.file);
+            file.conflict = true;
+            merged.push_back(file);
+            return;
+        }
+        
+        // Changed on both sides, or added on both with different content
+        std::string baseText, ourText, theirText;
+        MergedFile file = takeFile(path, &ourSide.file);
+        if ((before && !store->readBlob(std::string(before->blobId), baseText)) ||
+            !store->readBlob(std::string(ourSide.file.blobId), ourText) ||
+            !store->readBlob(std::string(after->blobId), theirText)) {
+            file.conflict = true;
+            merged.push_back(file);
+            return;
+        }
+        
+        std::string text;
+        file.conflict = !mergeText(baseText, ourText, theirText, oursLabel, theirsLabel, text);
+        file.blobId.clear();
+        file.size = text.size();
+        file.content = std::make_shared<const std::string>(std::move(text));
+        merged.push_back(file);
+    });
+    return merged;
+}
+
+// For each line of a, the index of the line of b it was kept as, or -1
+static void matchLines(const std::vector<std::string_view>& a, const std::vector<std::string_view>& b,
+                       std::vector<long>& match) {
+    std::vector<uint32_t> aIds, bIds;
+    std::vector<char> removed, added;
+    Diff::assignLineIds(a, b, aIds, bIds);
+    Diff::diffIds(aIds, bIds, DIFF_HISTOGRAM, removed, added);
+    
+    match.assign(a.size(), -1);
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        if (i < a.size() && removed[i]) {
+            i++;
+        } else if (j < b.size() && added[j]) {
+            j++;
+        } else {
+            match[i++] = static_cast<long>(j++);
+        }
+    }
+}
+
+static bool sameLines(const std::vector<std::string_view>& a, size_t aBegin, size_t aEnd,
+                      const std::vector<std::string_view>& b, size_t bBegin, size_t bEnd) {
+    if (aEnd - aBegin != bEnd - bBegin) {
+        return false;
+    }
+    for (size_t i = 0; i < aEnd - aBegin; i++) {
+        if (a[aBegin + i] != b[bBegin + i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void appendLines(std::string& out, const std::vector<std::string_view>& lines, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        out.append(lines[i].data(), lines[i].size());
+    }
+}
+
+// Markers must start a line even when the side before them ends without one
+static void appendMarker(std::string& out, const std::string& marker) {
+    if (!out.empty() && out.back() != '\n') {
+        out += '\n';
+    }
+    out += marker;
+}
+
+bool Merge::mergeText(const std::string& base, const std::string& ours, const std::string& theirs,
+                      const std::string& oursLabel, const std::string& theirsLabel, std::string& merged) {
+    merged.clear();
+    if (ours == theirs || theirs == base) {
+        merged = ours;
+        return true;
+    }
+    if (ours == base) {
+        merged = theirs;
+        return true;
+    }
+    if (base.find('\0') != std::string::npos || ours.find('\0') != std::string::npos ||
+        theirs.find('\0') != std::string::npos) {
+        merged = ours;
+        return false;
+    }
+    
+    std::vector<std::string_view> baseLines, ourLines, theirLines;
+    Diff::splitLines(base, baseLines);
+    Diff::splitLines(ours, ourLines);
+    Diff::splitLines(theirs, theirLines);
+    std::vector<long> ourMatch, theirMatch;
+    matchLines(baseLines, ourLines, ourMatch);
+    matchLines(baseLines, theirLines, theirMatch);
+    
+    // Base lines both sides kept split the files into chunks. In each chunk
+    // a side that left the base alone yields to the other; where both
+    // changed it differently, both versions go in as a conflict.
+    bool clean = true;
+    size_t b = 0, o = 0, t = 0;
+    while (true) {
+        size_t next = b;
+        while (next < baseLines.size() && (ourMatch[next] < 0 || theirMatch[next] < 0)) {
+            next++;
+        }
+        size_t ourEnd = next < baseLines.size() ? static_cast<size_t>(ourMatch[next]) : ourLines.size();
+        size_t theirEnd = next < baseLines.size() ? static_cast<size_t>(theirMatch[next]) : theirLines.size();
+        
+        if (sameLines(ourLines, o, ourEnd, baseLines, b, next) ||
+            sameLines(ourLines, o, ourEnd, theirLines, t, theirEnd)) {
+            appendLines(merged, theirLines, t, theirEnd);
+        } else if (sameLines(theirLines, t, theirEnd, baseLines, b, next)) {
+            appendLines(merged, ourLines, o, ourEnd);
+        } else {
+            clean = false;
+            appendMarker(merged, "<<<<<<< " + oursLabel + "\n");
+            appendLines(merged, ourLines, o, ourEnd);
+            appendMarker(merged, "=======\n");
+            appendLines(merged, theirLines, t, theirEnd);
+            appendMarker(merged, ">>>>>>> " + theirsLabel + "\n");
+        }
+        
+        if (next == baseLines.size()) {
+            break;
+        }
+        appendLines(merged, baseLines, next, next + 1);
+        b = next + 1;
+        o = ourEnd + 1;
+        t = theirEnd + 1;
+    }
+    return clean;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+#include "Commit.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+enum MergeStatus {
+    MERGE_UP_TO_DATE,       // Their commit is already an ancestor of ours
+    MERGE_FAST_FORWARD,     // Ours was an ancestor of theirs; moved to it
+    MERGE_COMMITTED,        // Merged cleanly into a new commit
+    MERGE_CONFLICTS,        // Merged into the working files, with conflicts to resolve
+    MERGE_FAILED
+};
+
+// A file of the merge result that differs from our side. Exactly one of
+// remove, blobId and content describes the result.
+struct MergedFile {
+    std::string path;
+    bool remove;
+    bool conflict;          // Changed differently on both sides
+    std::string blobId;     // An existing blob, taken from one side
+    size_t size;
+    std::shared_ptr<const std::string> content;    // Merged line by line
+};
+
+// Three-way merge of commits, trees and file contents
+class Merge {
+public:
+    // A common ancestor of a and b that is not an ancestor of another
+    // common ancestor, or null if they share no history. The walk goes
+    // from both commits in decreasing generation order and stops at the
+    // first commit reached from both, so it only visits commits newer than
+    // the base. Where there are several such ancestors (criss-cross
+    // merges), the one with the highest generation is chosen.
+    static Commit* findMergeBase(Commit* a, Commit* b);
+    
+    // Files of theirs merged into ours, as changes to ours. Both sides are
+    // compared against base with FileTree::compare, so directories neither
+    // side touched are skipped and the cost follows the changed set. Only
+    // files changed differently on both sides are read and merged by line.
+    static std::vector<MergedFile> mergeTrees(const FileTree& base, const FileTree& ours, const FileTree& theirs,
+                                              ObjectStore* store, const std::string& oursLabel,
+                                              const std::string& theirsLabel);
+    
+    // Line-level three-way merge; false if there were conflicts. Conflicting
+    // regions are written between <<<<<<< / ======= / >>>>>>> markers. Binary
+    // content (any NUL byte) is not merged: the result is ours, in conflict.
+    static bool mergeText(const std::string& base, const std::string& ours, const std::string& theirs,
+                          const std::string& oursLabel, const std::string& theirsLabel, std::string& merged);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,393 @@
+#include "ObjectStore.h"
+#include "Sha1.h"
+#include "Delta.h"
+#include "Compression.h"
+#include "BinaryIO.h"
+#include "Journal.h"
+#include "FileSync.h"
+#include "Trace.h"
+#include <fstream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+// Object file layout: magic "MVCO", format version, object type, delta
+// depth and payload codec, then the payload: either the content (keyframe)
+// or a base blob id followed by a delta against it. The content or delta
+// is compressed with the codec when that makes it smaller. Version 1
+// headers have no codec field, and objects written before the header
+// existed hold the raw content; both are still read.
+static const char OBJECT_MAGIC[4] = { 'M', 'V', 'C', 'O' };
+static const uint32_t OBJECT_FORMAT_VERSION = 2;
+static const uint32_t OBJECT_FULL = 0;
+static const uint32_t OBJECT_DELTA = 1;
+static const size_t OBJECT_HEADER_SIZE_V1 = 16;
+static const size_t OBJECT_HEADER_SIZE = 20;
+static const size_t BLOB_ID_LENGTH = 40;
+static const uint32_t DEFAULT_KEYFRAME_INTERVAL = 16;
+static const size_t DEFAULT_CACHE_LIMIT = 64 * 1024 * 1024;
+
+static std::string makeObjectHeader(uint32_t type, uint32_t depth, CompressionCodec codec) {
+    std::string header(OBJECT_MAGIC, 4);
+    appendU32(header, OBJECT_FORMAT_VERSION);
+    appendU32(header, type);
+    appendU32(header, depth);
+    appendU32(header, static_cast<uint32_t>(codec));
+    return header;
+}
+
+// Size of the object header, or 0 for a headerless object
+static size_t objectHeaderSize(const char* data, size_t size) {
+    if (size < OBJECT_HEADER_SIZE_V1 || data[0] != OBJECT_MAGIC[0] || data[1] != OBJECT_MAGIC[1] ||
+        data[2] != OBJECT_MAGIC[2] || data[3] != OBJECT_MAGIC[3]) {
+        return 0;
+    }
+    uint32_t version = readU32(data + 4);
+    if (version == 1) {
+        return OBJECT_HEADER_SIZE_V1;
+    }
+    if (version == OBJECT_FORMAT_VERSION && size >= OBJECT_HEADER_SIZE) {
+        return OBJECT_HEADER_SIZE;
+    }
+    return 0;
+}
+
+ObjectStore::ObjectStore()
+    : objectsPath("data/objects"), cacheBytes(0), cacheLimit(DEFAULT_CACHE_LIMIT),
+      keyframeInterval(DEFAULT_KEYFRAME_INTERVAL), codec(CODEC_LZ4), journal(nullptr) {
+}
+
+ObjectStore::ObjectStore(const std::string& path)
+    : objectsPath(path), cacheBytes(0), cacheLimit(DEFAULT_CACHE_LIMIT),
+      keyframeInterval(DEFAULT_KEYFRAME_INTERVAL), codec(CODEC_LZ4), journal(nullptr) {
+}
+
+void ObjectStore::setObjectsPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    objectsPath = path;
+    cache.clear();
+    cacheOrder.clear();
+    cacheBytes = 0;
+    depths.clear();
+}
+
+void ObjectStore::setCacheLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheLimit = bytes;
+    trimCache();
+}
+
+size_t ObjectStore::getCacheLimit() const {
+    return cacheLimit;
+}
+
+void ObjectStore::setKeyframeInterval(uint32_t interval) {
+    keyframeInterval = interval > 0 ? interval : 1;
+}
+
+uint32_t ObjectStore::getKeyframeInterval() const {
+    return keyframeInterval;
+}
+
+void ObjectStore::setCompression(CompressionCodec newCodec) {
+    codec = newCodec;
+}
+
+CompressionCodec ObjectStore::getCompression() const {
+    return codec;
+}
+
+void ObjectStore::setJournal(Journal* newJournal) {
+    journal = newJournal;
+}
+
+std::string ObjectStore::writeBlob(const std::string& content, const std::string& baseBlobId) {
+    TRACE_SCOPE("objects.writeBlob");
+    std::string blobId = hashContent(content);
+    
+    // Identical content is already on disk - nothing to write
+    if (hasBlob(blobId)) {
+        return blobId;
+    }
+    
+    // Try a delta against the previous revision unless the chain is due a keyframe
+    uint32_t type = OBJECT_FULL;
+    std::string delta;
+    uint32_t depth = 0;
+    uint32_t baseDepth;
+    std::shared_ptr<const std::string> base;
+    if (!baseBlobId.empty() && keyframeInterval > 1 && readObjectDepth(baseBlobId, baseDepth) &&
+        baseDepth + 1 < keyframeInterval && (base = readBlobBuffer(baseBlobId))) {
+        delta = Delta::encode(*base, content);
+        
+        // Only worth it when the delta is much smaller than the content
+        if (delta.size() < content.size() / 2) {
+            type = OBJECT_DELTA;
+            depth = baseDepth + 1;
+        } else {
+            delta.clear();
+        }
+    }
+    
+    const std::string& payload = (type == OBJECT_DELTA) ? delta : content;
+    std::string compressed;
+    CompressionCodec payloadCodec = CODEC_NONE;
+    if (codec != CODEC_NONE && !payload.empty()) {
+        compressed = Compression::compress(payload.data(), payload.size(), codec);
+        if (compressed.size() < payload.size()) {
+            payloadCodec = codec;
+        } else {
+            compressed.clear();
+        }
+    }
+    
+    std::string object = makeObjectHeader(type, depth, payloadCodec);
+    if (type == OBJECT_DELTA) {
+        object += baseBlobId;
+    }
+    object += (payloadCodec != CODEC_NONE) ? compressed : payload;
+    
+    // Inside a transaction the object goes through the journal with the
+    // commit that references it; otherwise it is replaced atomically
+    std::string path = getBlobPath(blobId);
+    if (!journal || !journal->write(path, object)) {
+#ifdef _WIN32
+        _mkdir(objectsPath.c_str());
+        _mkdir(getBlobDirectory(blobId).c_str());
+#else
+        mkdir(objectsPath.c_str(), 0755);
+        mkdir(getBlobDirectory(blobId).c_str(), 0755);
+#endif
+        if (!FileSync::replaceFile(path, object, false)) {
+            return "";
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    depths[blobId] = depth;
+    return blobId;
+}
+
+std::string ObjectStore::writeBlobBuffer(const std::shared_ptr<const std::string>& content,
+                                         const std::string& baseBlobId) {
+    std::string blobId = writeBlob(*content, baseBlobId);
+    if (!blobId.empty()) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        addCached(blobId, content);
+    }
+    return blobId;
+}
+
+bool ObjectStore::readBlob(const std::string& blobId, std::string& content) {
+    std::shared_ptr<const std::string> buffer = readBlobBuffer(blobId);
+    if (!buffer) {
+        return false;
+    }
+    content = *buffer;
+    return true;
+}
+
+std::shared_ptr<const std::string> ObjectStore::readBlobBuffer(const std::string& blobId) {
+    return loadBlob(blobId, true);
+}
+
+bool ObjectStore::readBlobUncached(const std::string& blobId, std::string& content) {
+    std::shared_ptr<const std::string> buffer = loadBlob(blobId, false);
+    if (!buffer) {
+        return false;
+    }
+    content = *buffer;
+    return true;
+}
+
+// The cached content, or else the content read from disk, kept in the
+// cache only if keep is set
+std::shared_ptr<const std::string> ObjectStore::loadBlob(const std::string& blobId, bool keep) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        std::shared_ptr<const std::string> cached = findCached(blobId);
+        if (cached) {
+            return cached;
+        }
+    }
+    
+    // Not locked while decoding: rebuilding a delta reads its base through here
+    
+    std::string raw;
+    if (!readObjectFile(blobId, raw)) {
+        return nullptr;
+    }
+    
+    std::shared_ptr<std::string> content = std::make_shared<std::string>();
+    if (!decodeObject(blobId, raw, *content, keep)) {
+        return nullptr;
+    }
+    if (!keep) {
+        return content;
+    }
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    addCached(blobId, content);
+    return content;
+}
+
+bool ObjectStore::hasBlob(const std::string& blobId) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (cache.find(blobId) != cache.end()) {
+            return true;
+        }
+    }
+    std::string path = getBlobPath(blobId);
+    if (journal && journal->findStaged(path)) {
+        return true;
+    }
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+void ObjectStore::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+    cacheOrder.clear();
+    cacheBytes = 0;
+}
+
+std::shared_ptr<const std::string> ObjectStore::findCached(const std::string& blobId) {
+    auto it = cache.find(blobId);
+    if (it == cache.end()) {
+        return nullptr;
+    }
+    cacheOrder.splice(cacheOrder.begin(), cacheOrder, it->second.use);
+    return it->second.content;
+}
+
+void ObjectStore::addCached(const std::string& blobId, const std::shared_ptr<const std::string>& content) {
+    auto it = cache.find(blobId);
+    if (it != cache.end()) {
+        cacheBytes -= it->second.content->size();
+        it->second.content = content;
+        cacheOrder.splice(cacheOrder.begin(), cacheOrder, it->second.use);
+    } else {
+        cacheOrder.push_front(blobId);
+        CacheEntry entry = { content, cacheOrder.begin() };
+        cache[blobId] = entry;
+    }
+    cacheBytes += content->size();
+    trimCache();
+}
+
+void ObjectStore::trimCache() {
+    // A content larger than the whole limit is dropped at once
+    while (cacheBytes > cacheLimit && !cacheOrder.empty()) {
+        auto it = cache.find(cacheOrder.back());
+        cacheBytes -= it->second.content->size();
+        cache.erase(it);
+        cacheOrder.pop_back();
+    }
+}
+
+std::string ObjectStore::hashContent(const std::string& content) {
+    return Sha1::hash(content);
+}
+
+bool ObjectStore::readObjectFile(const std::string& blobId, std::string& raw) {
+    std::string path = getBlobPath(blobId);
+    
+    // Written in a transaction that has not reached disk yet
+    const std::string* staged = journal ? journal->findStaged(path) : nullptr;
+    if (staged) {
+        raw = *staged;
+        return true;
+    }
+    
+    TRACE_SCOPE("objects.readObject");
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    TRACE_COUNT("fs.open", 1);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    raw.resize(static_cast<size_t>(size));
+    TRACE_COUNT("fs.bytes_read", size);
+    if (size > 0 && !file.read(&raw[0], size)) {
+        return false;
+    }
+    return true;
+}
+
+bool ObjectStore::readObjectDepth(const std::string& blobId, uint32_t& depth) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = depths.find(blobId);
+        if (it != depths.end()) {
+            depth = it->second;
+            return true;
+        }
+    }
+    
+    std::ifstream file(getBlobPath(blobId), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    // Only the header is needed; headerless objects are full copies
+    char header[OBJECT_HEADER_SIZE];
+    file.read(header, OBJECT_HEADER_SIZE);
+    depth = objectHeaderSize(header, static_cast<size_t>(file.gcount())) ? readU32(header + 12) : 0;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    depths[blobId] = depth;
+    return true;
+}
+
+bool ObjectStore::decodeObject(const std::string& blobId, const std::string& raw, std::string& content, bool keep) {
+    size_t headerSize = objectHeaderSize(raw.data(), raw.size());
+    if (headerSize > 0) {
+        uint32_t type = readU32(raw.data() + 8);
+        uint32_t payloadCodec = (headerSize == OBJECT_HEADER_SIZE) ? readU32(raw.data() + 16) : static_cast<uint32_t>(CODEC_NONE);
+        size_t payloadStart = headerSize + (type == OBJECT_DELTA ? BLOB_ID_LENGTH : 0);
+        
+        // Decompress the payload if needed
+        std::string decompressed;
+        const char* payload = raw.data() + payloadStart;
+        size_t payloadSize = raw.size() >= payloadStart ? raw.size() - payloadStart : 0;
+        bool payloadOk = raw.size() >= payloadStart;
+        if (payloadOk && payloadCodec != CODEC_NONE) {
+            payloadOk = Compression::decompress(payload, payloadSize, decompressed);
+            payload = decompressed.data();
+            payloadSize = decompressed.size();
+        }
+        
+        if (payloadOk && type == OBJECT_FULL) {
+            content.assign(payload, payloadSize);
+            return true;
+        }
+        
+        // Rebuild from the base revision, which may itself be a delta
+        std::shared_ptr<const std::string> base;
+        if (payloadOk && type == OBJECT_DELTA &&
+            (base = loadBlob(raw.substr(headerSize, BLOB_ID_LENGTH), keep)) &&
+            Delta::apply(*base, payload, payloadSize, content)) {
+            return true;
+        }
+    }
+    
+    // Headerless object from before the header existed: raw content
+    if (hashContent(raw) != blobId) {
+        return false;
+    }
+    content = raw;
+    return true;
+}
+
+std::string ObjectStore::getBlobDirectory(const std::string& blobId) {
+    // Fan out by the first two hex digits to keep directories small
+    return objectsPath + "/" + blobId.substr(0, 2);
+}
+
+std::string ObjectStore::getBlobPath(const std::string& blobId) {
+    return getBlobDirectory(blobId) + "/" + blobId.substr(2);
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef OBJECTSTORE_H
+#define OBJECTSTORE_H
+
+#include "Compression.h"
+#include <string>
+#include <unordered_map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+class Journal;
+
+// Content-addressed blob store kept under <dataPath>/objects/.
+// Every distinct file content is written once, named by its SHA-1 digest,
+// so commits only need to reference the digest of each file.
+//
+// A new revision of a file can be stored as a delta against the previous
+// revision. Every keyframeInterval revisions a full copy is written, so
+// rebuilding any version takes fewer than keyframeInterval delta steps.
+// Object payloads are block-compressed with the configured codec.
+//
+// Contents are cached as immutable shared buffers, so callers that keep a
+// buffer share the bytes with the cache instead of copying them. The cache
+// holds at most cacheLimit bytes and drops the least recently used
+// contents first; buffers callers still hold stay valid.
+//
+// While a journal transaction is open, new objects are staged in the
+// journal and only reach objects/ once it has been flushed.
+//
+// Reads may run on several threads at once; the caches are locked. Writes
+// must not overlap with each other or with reads.
+class ObjectStore {
+private:
+    std::string objectsPath;
+    struct CacheEntry {
+        std::shared_ptr<const std::string> content;
+        std::list<std::string>::iterator use;   // Position in cacheOrder
+    };
+    std::unordered_map<std::string, CacheEntry> cache;  // blob id -> content
+    std::list<std::string> cacheOrder;  // Blob ids, most recently used first
+    size_t cacheBytes;
+    size_t cacheLimit;
+    std::unordered_map<std::string, uint32_t> depths;   // blob id -> deltas since last keyframe
+    std::mutex cacheMutex;      // Guards cache and depths
+    uint32_t keyframeInterval;
+    CompressionCodec codec;
+    Journal* journal;           // Owned by FileHandler; may be null
+    
+public:
+    ObjectStore();
+    ObjectStore(const std::string& path);
+    
+    void setObjectsPath(const std::string& path);
+    void setKeyframeInterval(uint32_t interval);
+    uint32_t getKeyframeInterval() const;
+    void setCompression(CompressionCodec newCodec);
+    CompressionCodec getCompression() const;
+    void setJournal(Journal* newJournal);
+    void setCacheLimit(size_t bytes);
+    size_t getCacheLimit() const;
+    
+    // Store content (if not already present) and return its blob id.
+    // baseBlobId names the previous revision to delta against, if any.
+    std::string writeBlob(const std::string& content, const std::string& baseBlobId = "");
+    
+    // As writeBlob, and keep the buffer itself as the cached content
+    std::string writeBlobBuffer(const std::shared_ptr<const std::string>& content, const std::string& baseBlobId = "");
+    
+    // Fetch content by blob id, reading it from disk on first use
+    bool readBlob(const std::string& blobId, std::string& content);
+    
+    // Shared buffer for the content, or null if the blob cannot be read
+    std::shared_ptr<const std::string> readBlobBuffer(const std::string& blobId);
+    
+    // As readBlob, but nothing read from disk, delta bases included, is
+    // added to the cache; for scans over the whole history
+    bool readBlobUncached(const std::string& blobId, std::string& content);
+    bool hasBlob(const std::string& blobId);
+    
+    void clearCache();
+    
+    static std::string hashContent(const std::string& content);
+    
+private:
+    bool readObjectFile(const std::string& blobId, std::string& raw);
+    bool readObjectDepth(const std::string& blobId, uint32_t& depth);
+    std::shared_ptr<const std::string> loadBlob(const std::string& blobId, bool keep);
+    // Cache helpers; cacheMutex must be held
+    std::shared_ptr<const std::string> findCached(const std::string& blobId);
+    void addCached(const std::string& blobId, const std::shared_ptr<const std::string>& content);
+    void trimCache();
+    bool decodeObject(const std::string& blobId, const std::string& raw, std::string& content, bool keep);
+    std::string getBlobDirectory(const std::string& blobId);
+    std::string getBlobPath(const std::string& blobId);
+};
+
+#endif
\ No newline at end of file
@@ -1,14 +1,54 @@
 #include "Repository.h"
+#include "Trace.h"
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <queue>
+#include <cctype>
+
+// Modification time for an edit. Strictly increasing, so two edits of the
+// same size never share a (size, mtime) pair in the working index.
+// Shared by every repository in the process, so it advances atomically.
+static int64_t nextModificationTime() {
+    static std::atomic<int64_t> lastTime(0);
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t previous = lastTime.load();
+    int64_t next;
+    do {
+        next = (now > previous) ? now : previous + 1;
+    } while (!lastTime.compare_exchange_weak(previous, next));
+    return next;
+}
+
+// Branch names travel as single words in requests and as line ends in
+// branches.txt
+static bool isValidBranchName(const std::string& name) {
+    if (name.empty()) {
+        return false;
+    }
+    for (char c : name) {
+        if (std::isspace(static_cast<unsigned char>(c)) || std::iscntrl(static_cast<unsigned char>(c))) {
+            return false;
+        }
+    }
+    return true;
+}
 
 Repository::Repository() 
-    : head(nullptr), current(nullptr), nextVersionId(1), initialized(false), dataPath("data") {
+    : current(nullptr), mergeParent(nullptr), commitCount(0), nextVersionId(1), initialized(false), dataPath("data") {
+    objectStore = fileHandler.getObjectStore();
+    workingIndex = fileHandler.getWorkingIndex();
+    searchIndex = fileHandler.getSearchIndex();
 }
 
 Repository::Repository(const std::string& repoDataPath) 
-    : head(nullptr), current(nullptr), nextVersionId(1), initialized(false), dataPath(repoDataPath) {
+    : current(nullptr), mergeParent(nullptr), commitCount(0), nextVersionId(1), initialized(false), dataPath(repoDataPath) {
     fileHandler.setDataPath(repoDataPath);
+    objectStore = fileHandler.getObjectStore();
+    workingIndex = fileHandler.getWorkingIndex();
+    searchIndex = fileHandler.getSearchIndex();
 }
 
 void Repository::setDataPath(const std::string& path) {
@@ -16,6 +56,23 @@ void Repository::setDataPath(const std::string& path) {
     fileHandler.setDataPath(path);
 }
 
+bool Repository::setDeltaKeyframeInterval(int interval) {
+    if (interval < 1) {
+        return false;
+    }
+    objectStore->setKeyframeInterval(static_cast<uint32_t>(interval));
+    return !initialized || saveRepository();
+}
+
+bool Repository::setCompression(const std::string& codecName) {
+    CompressionCodec codec;
+    if (!Compression::parseCodec(codecName, codec)) {
+        return false;
+    }
+    objectStore->setCompression(codec);
+    return !initialized || saveRepository();
+}
+
 Repository::~Repository() {
     clearCommitHistory();
 }
@@ -26,15 +83,19 @@ bool Repository::initializeRepo() {
     }
     
     // Create initial commit
-    Commit* initialCommit = new Commit(0, "Initial commit");
-    head = initialCommit;
+    Commit* initialCommit = commitArena.create<Commit>(commitArena, commitTrees, 0, "Initial commit", objectStore);
     current = initialCommit;
+    registerCommit(initialCommit);
+    branches["main"] = initialCommit;
+    currentBranch = "main";
+    workingIndex->setBaseVersionId(0);
     nextVersionId = 1;
     initialized = true;
     
     // Create data directory structure
     fileHandler.createDirectory(dataPath);
     fileHandler.createDirectory(dataPath + "/commits");
+    fileHandler.createDirectory(dataPath + "/objects");
     
     return saveRepository();
 }
@@ -44,42 +105,119 @@ bool Repository::addFile(const std::string& filename, const std::string& content
         return false;
     }
     
-    workingDirectory[filename] = content;
+    WorkingFile& file = workingDirectory[filename];
+    file.blobId.clear();
+    file.size = content.length();
+    file.mtime = nextModificationTime();
+    file.content = std::make_shared<const std::string>(content);
+    file.removed = false;
+    return true;
+}
+
+bool Repository::removeFile(const std::string& filename) {
+    if (!initialized) {
+        return false;
+    }
+    
+    bool committed = current && current->hasFile(filename);
+    auto edited = workingDirectory.find(filename);
+    if (!committed) {
+        // Never committed: dropping the edit removes it
+        if (edited == workingDirectory.end() || edited->second.removed) {
+            return false;
+        }
+        workingDirectory.erase(edited);
+        workingIndex->remove(filename);
+        return true;
+    }
+    
+    WorkingFile& file = workingDirectory[filename];
+    file.blobId.clear();
+    file.size = 0;
+    file.mtime = nextModificationTime();
+    file.content.reset();
+    file.removed = true;
+    WorkingIndexEntry entry = { 0, file.mtime, "", true };
+    workingIndex->put(filename, entry);
     return true;
 }
 
 bool Repository::commitChanges(const std::string& message) {
-    if (!initialized || workingDirectory.empty()) {
+    TRACE_SCOPE("repo.commitChanges");
+    if (!initialized || (workingDirectory.empty() && (!current || current->files.empty()))) {
         return false;
     }
     
+    // Objects, the commit file and metadata are journaled as one transaction
+    fileHandler.beginTransaction();
+    
+    // Only the edited files are hashed and written to the object store. A
+    // commit must not name content the store failed to take, so nothing
+    // changes until every edit is stored; the edits stay for a retry.
+    for (auto& file : workingDirectory) {
+        if (!storeWorkingFile(file.first, file.second)) {
+            fileHandler.commitTransaction();
+            return false;
+        }
+    }
+    
     // Create new commit
-    Commit* newCommit = new Commit(nextVersionId++, message);
+    Commit* newCommit = commitArena.create<Commit>(commitArena, commitTrees, nextVersionId, message, objectStore);
     
-    // Copy all files from working directory
-    for (const auto& file : workingDirectory) {
-        newCommit->addFile(file.first, file.second);
+    // Unchanged directories are shared with the current commit
+    std::vector<TreeEdit> edits;
+    edits.reserve(workingDirectory.size());
+    for (auto& file : workingDirectory) {
+        TreeEdit edit;
+        edit.path = file.first;
+        edit.file.blobId = file.second.blobId;
+        edit.file.size = file.second.size;
+        edit.remove = file.second.removed;
+        edits.push_back(edit);
     }
+    newCommit->files = commitTrees.apply(current ? current->files : FileTree(), edits);
     
-    // Link to previous commit
-    newCommit->prev = current;
+    // The commit it was made on is its first parent, and a merge's other
+    // side its second
+    Commit* parents[2] = { current, mergeParent };
     if (current) {
-        current->next = newCommit;
+        newCommit->setParents(commitArena, parents, mergeParent ? 2 : 1);
+    } else {
+        newCommit->setParents(commitArena, parents + 1, mergeParent ? 1 : 0);
+    }
+    
+    // Save commit to file before it becomes current, so a failure leaves
+    // the branch, the edits and the version counter as they were; the
+    // unused commit stays in the arena until the history is cleared
+    if (!fileHandler.saveCommit(newCommit)) {
+        fileHandler.commitTransaction();
+        return false;
     }
+    nextVersionId++;
+    mergeParent = nullptr;
     
-    // Update pointers
+    // Advance the current branch; a detached commit is only reachable by id
     current = newCommit;
-    if (!head || head->versionId == 0) {
-        head = newCommit;
+    if (!currentBranch.empty()) {
+        branches[currentBranch] = newCommit;
     }
+    registerCommit(newCommit);
     
-    // Save commit to file
-    fileHandler.saveCommit(newCommit);
+    // The edits are now part of the current commit
+    workingDirectory.clear();
+    workingIndex->clear();
+    workingIndex->setBaseVersionId(newCommit->versionId);
     
-    return saveRepository();
+    bool saved = saveRepository();
+    saved = fileHandler.commitTransaction() && saved;
+    
+    // Indexed once on disk; a failure here is made up by the next search
+    searchIndex->addCommit(newCommit, objectStore);
+    return saved;
 }
 
 bool Repository::revertToCommit(int versionId) {
+    TRACE_SCOPE("repo.revertToCommit");
     if (!initialized) {
         return false;
     }
@@ -92,92 +230,363 @@ bool Repository::revertToCommit(int versionId) {
     // Push current state to undo stack
     undoStack.push(current);
     
-    // Update current commit and working directory
+    // Update current commit and working directory. Later commits stay on
+    // the branch, so unless this is its tip, new work starts a separate line
     current = targetCommit;
+    auto branch = branches.find(currentBranch);
+    if (branch == branches.end() || branch->second != targetCommit) {
+        currentBranch.clear();
+    }
     updateWorkingDirectory(targetCommit);
     
-    return true;
+    return saveRepository();
+}
+
+bool Repository::createBranch(const std::string& name, int versionId) {
+    if (!initialized || !isValidBranchName(name) || branches.count(name)) {
+        return false;
+    }
+    
+    Commit* tip = (versionId < 0) ? current : findCommitById(versionId);
+    if (!tip) {
+        return false;
+    }
+    branches[name] = tip;
+    return saveRepository();
+}
+
+bool Repository::deleteBranch(const std::string& name) {
+    auto branch = branches.find(name);
+    if (!initialized || branch == branches.end() || name == currentBranch) {
+        return false;
+    }
+    branches.erase(branch);
+    return saveRepository();
+}
+
+bool Repository::switchBranch(const std::string& name) {
+    auto branch = branches.find(name);
+    if (!initialized || branch == branches.end()) {
+        return false;
+    }
+    
+    Commit* target = branch->second;
+    if (mergeParent) {
+        return false;
+    }
+    if (target != current) {
+        // An edit can only be carried over a file both commits agree on
+        for (const auto& file : workingDirectory) {
+            std::string currentBlobId = current ? current->getBlobId(file.first) : "";
+            std::string targetBlobId = target ? target->getBlobId(file.first) : "";
+            if (currentBlobId != targetBlobId) {
+                return false;
+            }
+        }
+    }
+    
+    undoStack.push(current);
+    current = target;
+    currentBranch = name;
+    workingIndex->setBaseVersionId(target ? target->versionId : 0);
+    return saveRepository();
+}
+
+std::map<std::string, int> Repository::getBranches() const {
+    std::map<std::string, int> tips;
+    for (const auto& branch : branches) {
+        tips[branch.first] = branch.second ? branch.second->versionId : 0;
+    }
+    return tips;
+}
+
+std::string Repository::getCurrentBranch() const {
+    return currentBranch;
+}
+
+MergeStatus Repository::mergeBranch(const std::string& name, std::vector<std::string>& conflicts) {
+    conflicts.clear();
+    auto branch = branches.find(name);
+    if (!initialized || branch == branches.end() || mergeParent || !getStatus().empty()) {
+        return MERGE_FAILED;
+    }
+    
+    // The graph only holds saved commits; the initial commit is never saved
+    Commit* theirs = branch->second;
+    const CommitGraph& graph = fileHandler.getCommitGraph();
+    Commit* base = (current && theirs && graph.contains(current->versionId) && graph.contains(theirs->versionId))
+                   ? findCommitById(graph.findMergeBase(current->versionId, theirs->versionId))
+                   : Merge::findMergeBase(current, theirs);
+    if (!theirs || base == theirs) {
+        return MERGE_UP_TO_DATE;
+    }
+    if (base == current) {
+        // Nothing of ours to merge: move to their commit
+        undoStack.push(current);
+        current = theirs;
+        if (!currentBranch.empty()) {
+            branches[currentBranch] = theirs;
+        }
+        updateWorkingDirectory(theirs);
+        return saveRepository() ? MERGE_FAST_FORWARD : MERGE_FAILED;
+    }
+    
+    // The merged files become working edits; one taken whole from their
+    // side keeps its blob and is never read
+    std::string oursLabel = currentBranch.empty() ? std::to_string(current->versionId) : currentBranch;
+    std::vector<MergedFile> merged = Merge::mergeTrees(base ? base->files : FileTree(), current->files,
+                                                       theirs->files, objectStore, oursLabel, name);
+    for (MergedFile& merge : merged) {
+        WorkingFile& file = workingDirectory[merge.path];
+        file.blobId = merge.blobId;
+        file.size = merge.size;
+        file.mtime = nextModificationTime();
+        file.content = merge.content;
+        file.removed = merge.remove;
+        if (!merge.content) {
+            WorkingIndexEntry entry = { file.size, file.mtime, file.blobId, file.removed };
+            workingIndex->put(merge.path, entry);
+        }
+        if (merge.conflict) {
+            conflicts.push_back(merge.path);
+        }
+    }
+    mergeParent = theirs;
+    
+    if (!conflicts.empty()) {
+        std::sort(conflicts.begin(), conflicts.end());
+        return saveRepository() ? MERGE_CONFLICTS : MERGE_FAILED;
+    }
+    return commitChanges("Merge branch '" + name + "'") ? MERGE_COMMITTED : MERGE_FAILED;
+}
+
+bool Repository::isMerging() const {
+    return mergeParent != nullptr;
+}
+
+void Repository::beginBatch() {
+    fileHandler.beginBatch();
+}
+
+bool Repository::endBatch() {
+    return fileHandler.endBatch();
+}
+
+bool Repository::repack(size_t& packedCount) {
+    packedCount = 0;
+    return initialized && fileHandler.repackCommits(packedCount);
 }
 
 std::vector<Commit*> Repository::getCommitHistory() const {
+    // Every ancestor of the current commit, newest first. Parents always
+    // have lower ids than their children, so always taking the highest id
+    // pending lists merged lines interleaved by age.
+    auto olderFirst = [](const Commit* a, const Commit* b) { return a->versionId < b->versionId; };
+    std::priority_queue<Commit*, std::vector<Commit*>, decltype(olderFirst)> pending(olderFirst);
+    std::vector<bool> seen(commitTable.size(), false);
     std::vector<Commit*> history;
-    Commit* commit = head;
     
-    while (commit) {
+    if (current) {
+        pending.push(current);
+        seen[current->versionId] = true;
+    }
+    while (!pending.empty()) {
+        Commit* commit = pending.top();
+        pending.pop();
         history.push_back(commit);
-        commit = commit->prev;
+        for (uint32_t i = 0; i < commit->parentCount; i++) {
+            Commit* parent = commit->parents[i];
+            if (!seen[parent->versionId]) {
+                seen[parent->versionId] = true;
+                pending.push(parent);
+            }
+        }
     }
     
     return history;
 }
 
+bool Repository::isAncestor(int ancestorId, int descendantId) const {
+    return fileHandler.getCommitGraph().isAncestor(ancestorId, descendantId);
+}
+
+int Repository::getMergeBase(int versionIdA, int versionIdB) const {
+    return fileHandler.getCommitGraph().findMergeBase(versionIdA, versionIdB);
+}
+
+bool Repository::search(const std::string& pattern, bool regex, size_t maxHits, std::vector<SearchHit>& hits) const {
+    TRACE_SCOPE("repo.search");
+    hits.clear();
+    if (!initialized) {
+        return false;
+    }
+    return searchIndex->search(pattern, regex, maxHits, commitTable, objectStore, hits);
+}
+
 Commit* Repository::getCurrentCommit() const {
     return current;
 }
 
+Commit* Repository::getCommitById(int versionId) const {
+    return findCommitById(versionId);
+}
+
 std::string Repository::getFileContent(const std::string& filename) const {
+    std::shared_ptr<const std::string> buffer = getFileBuffer(filename);
+    return buffer ? *buffer : "";
+}
+
+std::shared_ptr<const std::string> Repository::getFileBuffer(const std::string& filename) const {
+    auto it = workingDirectory.find(filename);
+    if (it == workingDirectory.end()) {
+        // Unedited: page the committed content in from the object store
+        return current ? current->getFileBuffer(filename) : nullptr;
+    }
+    if (it->second.removed) {
+        return nullptr;
+    }
+    if (it->second.content) {
+        return it->second.content;
+    }
+    return objectStore->readBlobBuffer(it->second.blobId);
+}
+
+size_t Repository::getFileSize(const std::string& filename) const {
     auto it = workingDirectory.find(filename);
     if (it != workingDirectory.end()) {
-        return it->second;
+        return it->second.size;
     }
-    return "";
+    return current ? current->getFileSize(filename) : 0;
 }
 
 std::vector<std::string> Repository::getWorkingFiles() const {
     std::vector<std::string> files;
+    if (current) {
+        files.reserve(current->files.size() + workingDirectory.size());
+        for (const auto& file : current->files) {
+            auto edited = workingDirectory.find(std::string(file.first));
+            if (edited == workingDirectory.end() || !edited->second.removed) {
+                files.emplace_back(file.first);
+            }
+        }
+    }
     for (const auto& file : workingDirectory) {
-        files.push_back(file.first);
+        if (!file.second.removed && (!current || !current->hasFile(file.first))) {
+            files.push_back(file.first);
+        }
     }
     return files;
 }
 
+std::vector<FileChange> Repository::getStatus() {
+    std::vector<FileChange> changes;
+    
+    // Only edited files can differ, and of those only the ones whose size
+    // or mtime moved since they were last hashed are read
+    for (auto it = workingDirectory.begin(); it != workingDirectory.end(); ) {
+        std::string committedBlobId = current ? current->getBlobId(it->first) : "";
+        std::string blobId = it->second.removed ? "" : hashWorkingFile(it->first, it->second);
+        
+        if (blobId == committedBlobId) {
+            // Edited back to the committed content
+            workingIndex->remove(it->first);
+            it = workingDirectory.erase(it);
+            continue;
+        }
+        
+        FileChange change;
+        change.filename = it->first;
+        change.status = it->second.removed ? FILE_REMOVED : committedBlobId.empty() ? FILE_ADDED : FILE_MODIFIED;
+        changes.push_back(change);
+        ++it;
+    }
+    
+    std::sort(changes.begin(), changes.end(),
+              [](const FileChange& a, const FileChange& b) { return a.filename < b.filename; });
+    return changes;
+}
+
 bool Repository::isInitialized() const {
     return initialized;
 }
 
 int Repository::getTotalCommits() const {
-    int count = 0;
-    Commit* commit = head;
-    while (commit) {
-        if (commit->versionId > 0) { // Skip initial commit
-            count++;
-        }
-        commit = commit->prev;
-    }
-    return count;
+    return commitCount;
 }
 
 bool Repository::saveRepository() {
-    return fileHandler.saveRepositoryMetadata(nextVersionId, initialized);
+    fileHandler.beginTransaction();
+    if (initialized) {
+        // Store pending edits so the working tree survives a restart
+        for (auto& file : workingDirectory) {
+            storeWorkingFile(file.first, file.second);
+        }
+    }
+    bool saved = fileHandler.saveRepositoryMetadata(nextVersionId, initialized);
+    if (initialized) {
+        saved = saveBranches() && saved;
+    }
+    saved = fileHandler.commitTransaction() && saved;
+    
+    // The working index names stored objects, so it goes after them
+    if (initialized) {
+        workingIndex->save();
+    }
+    return saved;
 }
 
 bool Repository::loadRepository() {
+    TRACE_SCOPE("repo.loadRepository");
     int loadedVersionId;
     bool loadedInitialized;
     
+    // Finish any commit a crash interrupted before reading anything
+    fileHandler.recoverJournal();
+    
     if (fileHandler.loadRepositoryMetadata(loadedVersionId, loadedInitialized)) {
         nextVersionId = loadedVersionId;
         initialized = loadedInitialized;
         
-        // Load commits from files
-        std::vector<Commit*> commits = fileHandler.loadAllCommits();
+        // Drop anything loaded before so reloading does not leak the old chain
+        clearCommitHistory();
+        workingDirectory.clear();
+        
+        // Load commit headers; file contents stay on disk until needed
+        std::vector<std::vector<int>> parentIds;
+        std::vector<Commit*> commits = fileHandler.loadAllCommits(commitArena, commitTrees, parentIds);
+        
+        // Rebuild the commit graph. The initial commit is never saved, so
+        // parent ids naming it link to nothing
+        Commit* newest = nullptr;
+        for (Commit* commit : commits) {
+            registerCommit(commit);
+            if (!newest || commit->versionId > newest->versionId) {
+                newest = commit;
+            }
+        }
         
-        // Rebuild commit chain
-        if (!commits.empty()) {
-            // Sort commits by version ID
-            std::sort(commits.begin(), commits.end(), 
-                     [](Commit* a, Commit* b) { return a->versionId < b->versionId; });
-            
-            // Link commits
-            for (size_t i = 0; i < commits.size(); i++) {
-                if (i > 0) {
-                    commits[i]->prev = commits[i-1];
-                    commits[i-1]->next = commits[i];
+        // In id order: parents come first, so their generations are known
+        std::vector<size_t> order(commits.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(),
+                  [&](size_t a, size_t b) { return commits[a]->versionId < commits[b]->versionId; });
+        std::vector<Commit*> parents;
+        for (size_t i : order) {
+            parents.clear();
+            for (int parentId : parentIds[i]) {
+                Commit* parent = findCommitById(parentId);
+                if (parent) {
+                    parents.push_back(parent);
                 }
             }
-            
-            head = commits.back();
-            current = head;
+            commits[i]->setParents(commitArena, parents.data(), static_cast<uint32_t>(parents.size()));
+        }
+        loadBranches(newest);
+        
+        // Resume the saved working tree if it was checked out from current
+        if (!loadWorkingIndex()) {
             updateWorkingDirectory(current);
         }
         
@@ -188,28 +597,133 @@ bool Repository::loadRepository() {
 }
 
 void Repository::clearCommitHistory() {
-    while (head) {
-        Commit* temp = head;
-        head = head->prev;
-        delete temp;
-    }
+    // Every commit, including any no longer reachable from a branch, goes with the arena
+    commitTable.clear();
+    commitArena.release();
+    commitTrees.clear();
+    commitCount = 0;
     current = nullptr;
+    mergeParent = nullptr;
+    branches.clear();
+    currentBranch.clear();
+    undoStack = std::stack<Commit*>();
 }
 
-Commit* Repository::findCommitById(int versionId) const {
-    Commit* commit = head;
-    while (commit) {
-        if (commit->versionId == versionId) {
-            return commit;
+bool Repository::saveBranches() {
+    std::map<std::string, int> tips = getBranches();
+    return fileHandler.saveBranches(tips, currentBranch, current ? current->versionId : 0,
+                                    mergeParent ? mergeParent->versionId : 0);
+}
+
+void Repository::loadBranches(Commit* newest) {
+    std::map<std::string, int> tips;
+    std::string branch;
+    int currentVersionId = 0;
+    int mergeVersionId = 0;
+    if (fileHandler.loadBranches(tips, branch, currentVersionId, mergeVersionId)) {
+        for (const auto& tip : tips) {
+            branches[tip.first] = findCommitById(tip.second);
         }
-        commit = commit->prev;
+    } else {
+        // Saved before branches existed: the whole history is one line
+        branches["main"] = newest;
+        branch = "main";
+    }
+    
+    auto found = branches.find(branch);
+    if (found != branches.end()) {
+        currentBranch = branch;
+        current = found->second;
+    } else {
+        current = findCommitById(currentVersionId);
+    }
+    mergeParent = findCommitById(mergeVersionId);
+}
+
+void Repository::registerCommit(Commit* commit) {
+    if (commit->versionId < 0) {
+        return;
+    }
+    size_t slot = static_cast<size_t>(commit->versionId);
+    if (slot >= commitTable.size()) {
+        commitTable.resize(slot + 1, nullptr);
+    }
+    // A replaced commit stays in the arena until the history is cleared
+    if (!commitTable[slot] && commit->versionId > 0) {
+        commitCount++;
+    }
+    commitTable[slot] = commit;
+}
+
+Commit* Repository::findCommitById(int versionId) const {
+    if (versionId < 0 || static_cast<size_t>(versionId) >= commitTable.size()) {
+        return nullptr;
     }
-    return nullptr;
+    return commitTable[versionId];
 }
 
 void Repository::updateWorkingDirectory(Commit* commit) {
+    // Unedited files are read through the commit, so only the edits go,
+    // along with any merge they were part of
+    mergeParent = nullptr;
     workingDirectory.clear();
-    if (commit) {
-        workingDirectory = commit->files;
+    workingIndex->clear();
+    workingIndex->setBaseVersionId(commit ? commit->versionId : 0);
+}
+
+bool Repository::loadWorkingIndex() {
+    int baseVersionId = current ? current->versionId : 0;
+    if (!workingIndex->load() || workingIndex->getBaseVersionId() != baseVersionId) {
+        return false;
+    }
+    
+    for (const auto& entry : workingIndex->getEntries()) {
+        // Every saved entry should name stored content or a removal; anything else is unusable
+        if (!entry.second.removed &&
+            (entry.second.blobId.empty() || !objectStore->hasBlob(entry.second.blobId))) {
+            workingDirectory.clear();
+            return false;
+        }
+        
+        WorkingFile& file = workingDirectory[entry.first];
+        file.blobId = entry.second.blobId;
+        file.size = static_cast<size_t>(entry.second.size);
+        file.mtime = entry.second.mtime;
+        file.removed = entry.second.removed;
+    }
+    return true;
+}
+
+std::string Repository::hashWorkingFile(const std::string& filename, const WorkingFile& file) {
+    if (!file.blobId.empty()) {
+        return file.blobId;
     }
+    
+    std::string blobId = workingIndex->getCachedBlobId(filename, file.size, file.mtime);
+    if (blobId.empty()) {
+        blobId = ObjectStore::hashContent(*file.content);
+        WorkingIndexEntry entry = { file.size, file.mtime, blobId, false };
+        workingIndex->put(filename, entry);
+    }
+    return blobId;
+}
+
+bool Repository::storeWorkingFile(const std::string& filename, WorkingFile& file) {
+    if (!file.blobId.empty() || file.removed) {
+        return true;
+    }
+    
+    // Delta against the version in the current commit, if there is one
+    std::string previousBlobId = current ? current->getBlobId(filename) : "";
+    std::string blobId = objectStore->writeBlobBuffer(file.content, previousBlobId);
+    if (blobId.empty()) {
+        return false;
+    }
+    
+    // The store's cache now shares the buffer
+    file.blobId = blobId;
+    file.content.reset();
+    WorkingIndexEntry entry = { file.size, file.mtime, blobId, false };
+    workingIndex->put(filename, entry);
+    return true;
 }
\ No newline at end of file
@@ -3,17 +3,55 @@
 
 #include "Commit.h"
 #include "FileHandler.h"
+#include "Merge.h"
 #include <stack>
+#include <map>
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstdint>
+
+// A file edited since the current commit. Its content is an immutable
+// shared buffer; an edit swaps in a new buffer rather than changing the old
+// one, so the object store cache can hold the same bytes once stored.
+struct WorkingFile {
+    std::string blobId;     // Stored content, empty while only in memory
+    size_t size;            // Content length in bytes
+    int64_t mtime;          // When the content last changed
+    std::shared_ptr<const std::string> content;    // Only set while not yet stored
+    bool removed;           // Deleted; the other fields are unused
+};
+
+enum FileStatus {
+    FILE_ADDED,
+    FILE_MODIFIED,
+    FILE_REMOVED
+};
+
+// A working file that differs from the current commit
+struct FileChange {
+    std::string filename;
+    FileStatus status;
+};
 
 class Repository {
 private:
-    Commit* head;           // Latest commit (linked list head)
     Commit* current;        // Current commit position
+    std::map<std::string, Commit*> branches;    // Branch name -> tip commit
+    std::string currentBranch;  // Branch new commits advance, empty when detached
+    Commit* mergeParent;    // Second parent of the next commit while a merge is unfinished
     std::stack<Commit*> undoStack;  // For undo operations
-    std::unordered_map<std::string, std::string> workingDirectory; // Current files
+    Arena commitArena;      // Every commit and its message
+    TreePool commitTrees;   // Every commit's file tree
+    std::vector<Commit*> commitTable;   // versionId -> commit, every one in commitArena
+    int commitCount;        // Commits with versionId > 0
+    // Working files are the current commit's files overlaid with the ones
+    // edited since; checkout only has to drop the overlay
+    std::unordered_map<std::string, WorkingFile> workingDirectory; // Edited files
     FileHandler fileHandler;
+    ObjectStore* objectStore;   // Owned by fileHandler
+    WorkingIndex* workingIndex; // Owned by fileHandler
+    SearchIndex* searchIndex;   // Owned by fileHandler
     int nextVersionId;
     bool initialized;
     std::string dataPath;   // Path to repository data folder
@@ -26,19 +64,63 @@ public:
     // Repository path management
     void setDataPath(const std::string& path);
     
+    // Storage settings (persisted in repo_metadata.txt)
+    bool setDeltaKeyframeInterval(int interval);
+    bool setCompression(const std::string& codecName);
+    
     // Core VCS operations
     bool initializeRepo();
     bool addFile(const std::string& filename, const std::string& content);
+    bool removeFile(const std::string& filename);
     bool commitChanges(const std::string& message);
     bool revertToCommit(int versionId);
     
+    // Group commit for bulk imports: commits made between beginBatch and
+    // endBatch share one journal flush, and are durable once endBatch returns
+    void beginBatch();
+    bool endBatch();
+    
+    // Branches are named refs into the commit graph. A commit advances the
+    // current branch; reverting to anything but its tip detaches from it, so
+    // later commits start a new line instead of rewriting the branch.
+    bool createBranch(const std::string& name, int versionId = -1);  // -1 = current commit
+    bool deleteBranch(const std::string& name);
+    // Check out a branch's tip, keeping uncommitted edits. Unedited files are
+    // read through the new commit, so only edited files are looked at; the
+    // switch is refused if one of them also differs between the two commits.
+    bool switchBranch(const std::string& name);
+    std::map<std::string, int> getBranches() const;     // Name -> tip id, 0 before any commit
+    std::string getCurrentBranch() const;
+    
+    // Merge a branch into the current commit. Needs a clean working tree.
+    // A clean merge is committed with both tips as parents; otherwise the
+    // merged files, conflict markers and all, are left as working edits,
+    // and the next commit completes the merge. conflicts lists the files
+    // changed differently on both sides.
+    MergeStatus mergeBranch(const std::string& name, std::vector<std::string>& conflicts);
+    bool isMerging() const;
+    
+    // Move loose commit files into the repository's pack file; packedCount
+    // is the number of commits packed in total
+    bool repack(size_t& packedCount);
+    
     // Query operations
     std::vector<Commit*> getCommitHistory() const;
+    // Ancestry from the commit graph, without reading any commit
+    bool isAncestor(int ancestorId, int descendantId) const;
+    int getMergeBase(int versionIdA, int versionIdB) const;    // -1 if none
+    // Lines of committed files matching pattern, each under the commit that
+    // introduced it; see SearchIndex::search
+    bool search(const std::string& pattern, bool regex, size_t maxHits, std::vector<SearchHit>& hits) const;
     Commit* getCurrentCommit() const;
+    Commit* getCommitById(int versionId) const;
     std::string getFileContent(const std::string& filename) const;
+    std::shared_ptr<const std::string> getFileBuffer(const std::string& filename) const;
+    size_t getFileSize(const std::string& filename) const;
     std::vector<std::string> getWorkingFiles() const;
     
     // Status
+    std::vector<FileChange> getStatus();
     bool isInitialized() const;
     int getTotalCommits() const;
     
@@ -48,8 +130,14 @@ public:
     
 private:
     void clearCommitHistory();
+    bool saveBranches();
+    void loadBranches(Commit* newest);
+    void registerCommit(Commit* commit);
     Commit* findCommitById(int versionId) const;
     void updateWorkingDirectory(Commit* commit);
+    bool loadWorkingIndex();
+    std::string hashWorkingFile(const std::string& filename, const WorkingFile& file);
+    bool storeWorkingFile(const std::string& filename, WorkingFile& file);
 };
 
 #endif
\ No newline at end of file
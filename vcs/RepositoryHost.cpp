@@ -0,0 +1,93 @@
+#include "RepositoryHost.h"
+#include "FileSync.h"
+#include <sys/stat.h>
+
+RepositoryHost::RepositoryHost(const std::string& root) : rootPath(root) {
+}
+
+RepositoryHost::~RepositoryHost() {
+    saveAll();
+}
+
+bool RepositoryHost::withReader(const std::string& name, const std::function<void(const Repository&)>& fn) {
+    HostedRepository* hosted = open(name, false);
+    if (!hosted) {
+        return false;
+    }
+    
+    std::shared_lock<std::shared_mutex> lock(hosted->lock);
+    fn(*hosted->repository);
+    return true;
+}
+
+bool RepositoryHost::withWriter(const std::string& name, const std::function<void(Repository&)>& fn,
+                                bool createFolder) {
+    HostedRepository* hosted = open(name, createFolder);
+    if (!hosted) {
+        return false;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(hosted->lock);
+    fn(*hosted->repository);
+    return true;
+}
+
+void RepositoryHost::saveAll() {
+    std::lock_guard<std::mutex> hostLock(hostMutex);
+    for (auto& entry : repositories) {
+        std::unique_lock<std::shared_mutex> lock(entry.second->lock);
+        if (entry.second->loaded && entry.second->repository->isInitialized()) {
+            entry.second->repository->saveRepository();
+        }
+    }
+}
+
+bool RepositoryHost::isValidName(const std::string& name) {
+    // One path component, so a name cannot reach outside the root
+    return !name.empty() && name != "." && name != ".." &&
+           name.find_first_of("/\\:") == std::string::npos;
+}
+
+RepositoryHost::HostedRepository* RepositoryHost::open(const std::string& name, bool createFolder) {
+    if (!isValidName(name)) {
+        return nullptr;
+    }
+    
+    std::string dataPath = getDataPath(name);
+    HostedRepository* hosted;
+    {
+        std::lock_guard<std::mutex> hostLock(hostMutex);
+        auto it = repositories.find(name);
+        if (it != repositories.end()) {
+            hosted = it->second.get();
+        } else {
+            // Creates <root>/<name>/data, the parent of the file named here
+            if (createFolder) {
+                FileSync::createParentDirectories(dataPath + "/repo_metadata.txt");
+            }
+            struct stat info;
+            if (stat(dataPath.c_str(), &info) != 0 || !(info.st_mode & S_IFDIR)) {
+                return nullptr;
+            }
+            
+            std::unique_ptr<HostedRepository> created(new HostedRepository());
+            created->repository.reset(new Repository(dataPath));
+            hosted = created.get();
+            repositories[name] = std::move(created);
+        }
+    }
+    
+    // Load outside the map lock so other repositories are not held up
+    if (!hosted->loaded) {
+        std::unique_lock<std::shared_mutex> lock(hosted->lock);
+        if (!hosted->loaded) {
+            hosted->repository->loadRepository();
+            hosted->loaded = true;
+        }
+    }
+    return hosted;
+}
+
+std::string RepositoryHost::getDataPath(const std::string& name) const {
+    return rootPath + "/" + name + "/data";
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef REPOSITORYHOST_H
+#define REPOSITORYHOST_H
+
+#include "Repository.h"
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <functional>
+
+// Keeps any number of repositories open at once, named as in the console
+// app (<rootPath>/<name>/data). Each repository has its own reader/writer
+// lock: history and file reads share it and run in parallel, while
+// anything that changes the repository takes it exclusively. Different
+// repositories never wait on each other except for the first lookup.
+class RepositoryHost {
+private:
+    struct HostedRepository {
+        std::shared_mutex lock;
+        std::unique_ptr<Repository> repository;
+        std::atomic<bool> loaded;
+        HostedRepository() : loaded(false) {}
+    };
+    
+    std::string rootPath;
+    std::mutex hostMutex;   // Guards the map only
+    std::unordered_map<std::string, std::unique_ptr<HostedRepository>> repositories;
+
+public:
+    RepositoryHost(const std::string& root = "repos");
+    ~RepositoryHost();
+    
+    // Run fn under the repository's shared or exclusive lock. Returns false
+    // without calling fn if the name is invalid or the repository's folder
+    // does not exist; createFolder makes the folder first.
+    bool withReader(const std::string& name, const std::function<void(const Repository&)>& fn);
+    bool withWriter(const std::string& name, const std::function<void(Repository&)>& fn,
+                    bool createFolder = false);
+    
+    // Save every open repository, keeping uncommitted edits
+    void saveAll();
+    
+    static bool isValidName(const std::string& name);
+
+private:
+    HostedRepository* open(const std::string& name, bool createFolder);
+    std::string getDataPath(const std::string& name) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "RepositoryServer.h"
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+typedef SOCKET SocketHandle;
+#define closeSocket closesocket
+#define SHUT_RDWR SD_BOTH
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define closeSocket ::close
+#endif
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;  // A vanished client must not kill the server
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+// Buffered line/byte reads and full writes on one client connection
+class ClientConnection {
+private:
+    SocketHandle socket;
+    std::string buffer;
+    size_t position;
+
+public:
+    ClientConnection(SocketHandle clientSocket) : socket(clientSocket), position(0) {}
+    
+    bool readLine(std::string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n', position);
+            if (newline != std::string::npos) {
+                line.assign(buffer, position, newline - position);
+                position = newline + 1;
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                return true;
+            }
+            if (!fill()) {
+                return false;
+            }
+        }
+    }
+    
+    bool readBytes(size_t size, std::string& data) {
+        while (buffer.size() - position < size) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        data.assign(buffer, position, size);
+        position += size;
+        return true;
+    }
+    
+    bool sendAll(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            int chunk = static_cast<int>(std::min<size_t>(data.size() - sent, 1u << 30));
+            int count = static_cast<int>(::send(socket, data.data() + sent, chunk, SEND_FLAGS));
+            if (count <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+private:
+    bool fill() {
+        // Drop what has been consumed before growing the buffer
+        buffer.erase(0, position);
+        position = 0;
+        
+        char chunk[65536];
+        int count = static_cast<int>(::recv(socket, chunk, sizeof(chunk), 0));
+        if (count <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(count));
+        return true;
+    }
+};
+
+
+RepositoryServer::RepositoryServer(RepositoryHost& repositoryHost)
+    : handler(repositoryHost), listenSocket(-1), running(false) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+}
+
+RepositoryServer::~RepositoryServer() {
+    closeListenSocket();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool RepositoryServer::listen(const std::string& path) {
+    closeListenSocket();
+    
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    path.copy(address.sun_path, path.size());
+    
+    SocketHandle server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+#ifdef _WIN32
+    if (server == INVALID_SOCKET) {
+        return false;
+    }
+    DeleteFileA(path.c_str());
+#else
+    if (server < 0) {
+        return false;
+    }
+    ::unlink(path.c_str());
+#endif
+    
+    if (::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(server, SOMAXCONN) != 0) {
+        closeSocket(server);
+        return false;
+    }
+    
+    socketPath = path;
+    listenSocket = static_cast<intptr_t>(server);
+    running = true;
+    return true;
+}
+
+void RepositoryServer::run() {
+    while (running) {
+        SocketHandle client = ::accept(static_cast<SocketHandle>(listenSocket), nullptr, nullptr);
+#ifdef _WIN32
+        if (client == INVALID_SOCKET) {
+#else
+        if (client < 0) {
+#endif
+            if (!running) {
+                break;
+            }
+            continue;
+        }
+        
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clientSockets.push_back(static_cast<intptr_t>(client));
+        std::thread(&RepositoryServer::serveClient, this, static_cast<intptr_t>(client)).detach();
+    }
+    
+    // Wait for client threads; stop() has already cut their connections
+    std::unique_lock<std::mutex> lock(clientsMutex);
+    clientsDone.wait(lock, [this] { return clientSockets.empty(); });
+}
+
+void RepositoryServer::stop() {
+    running = false;
+    
+    // Unblock accept() and every client waiting on a request
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    if (listenSocket != -1) {
+        ::shutdown(static_cast<SocketHandle>(listenSocket), SHUT_RDWR);
+    }
+    for (intptr_t client : clientSockets) {
+        ::shutdown(static_cast<SocketHandle>(client), SHUT_RDWR);
+    }
+}
+
+void RepositoryServer::serveClient(intptr_t client) {
+    ClientConnection connection(static_cast<SocketHandle>(client));
+    std::string line;
+    while (running && connection.readLine(line)) {
+        size_t payloadSize;
+        std::string payload;
+        if (!RequestHandler::getPayloadSize(line, payloadSize)) {
+            RequestReply malformed = { false, "malformed request" };
+            connection.sendAll(RequestHandler::formatReply(malformed));
+            break;
+        }
+        if (payloadSize > 0 && !connection.readBytes(payloadSize, payload)) {
+            break;
+        }
+        
+        bool shutdown = false;
+        if (!connection.sendAll(RequestHandler::formatReply(handler.handle(line, payload, shutdown)))) {
+            break;
+        }
+        if (shutdown) {
+            stop();
+            break;
+        }
+    }
+    
+    // Deregister before closing, so stop() never touches a reused handle
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clientSockets.erase(std::find(clientSockets.begin(), clientSockets.end(), client));
+        if (clientSockets.empty()) {
+            clientsDone.notify_all();
+        }
+    }
+    closeSocket(static_cast<SocketHandle>(client));
+}
+
+void RepositoryServer::closeListenSocket() {
+    if (listenSocket == -1) {
+        return;
+    }
+    closeSocket(static_cast<SocketHandle>(listenSocket));
+    listenSocket = -1;
+#ifdef _WIN32
+    DeleteFileA(socketPath.c_str());
+#else
+    ::unlink(socketPath.c_str());
+#endif
+}
\ No newline at end of file
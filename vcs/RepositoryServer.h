@@ -0,0 +1,40 @@
+#ifndef REPOSITORYSERVER_H
+#define REPOSITORYSERVER_H
+
+#include "RequestHandler.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+// Serves a RepositoryHost over a local (Unix domain) socket, one thread
+// per connected client, speaking the RequestHandler protocol.
+class RepositoryServer {
+private:
+    RequestHandler handler;
+    std::string socketPath;
+    intptr_t listenSocket;  // -1 when not listening
+    std::atomic<bool> running;
+    std::mutex clientsMutex;
+    std::condition_variable clientsDone;
+    std::vector<intptr_t> clientSockets;    // Guarded by clientsMutex
+
+public:
+    RepositoryServer(RepositoryHost& repositoryHost);
+    ~RepositoryServer();
+    
+    // Bind the socket, replacing a stale socket file left at path
+    bool listen(const std::string& path);
+    
+    // Accept clients until SHUTDOWN or stop(); returns once all have disconnected
+    void run();
+    void stop();
+
+private:
+    void serveClient(intptr_t client);
+    void closeListenSocket();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "RequestHandler.h"
+#include "Diff.h"
+#include "Trace.h"
+#include <sstream>
+
+// Most lines a SEARCH or GREP reply lists
+static const size_t MAX_SEARCH_HITS = 1000;
+
+static std::vector<std::string> splitWords(const std::string& line) {
+    std::vector<std::string> words;
+    std::istringstream stream(line);
+    std::string word;
+    while (stream >> word) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+static bool parseVersion(const std::string& text, int& versionId) {
+    try {
+        size_t used;
+        versionId = std::stoi(text, &used);
+        return used == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+static RequestReply ok(const std::string& body) {
+    RequestReply reply = { true, body };
+    return reply;
+}
+
+static RequestReply error(const std::string& reason) {
+    RequestReply reply = { false, reason };
+    return reply;
+}
+
+RequestHandler::RequestHandler(RepositoryHost& repositoryHost) : host(repositoryHost) {
+}
+
+bool RequestHandler::getPayloadSize(const std::string& line, size_t& size) {
+    size = 0;
+    std::vector<std::string> words = splitWords(line);
+    if (words.empty() || words[0] != "ADD") {
+        return true;
+    }
+    if (words.size() != 4) {
+        return false;
+    }
+    try {
+        size_t used;
+        unsigned long long value = std::stoull(words[3], &used);
+        size = static_cast<size_t>(value);
+        return used == words[3].size() && words[3][0] != '-';
+    } catch (...) {
+        return false;
+    }
+}
+
+RequestReply RequestHandler::handle(const std::string& line, const std::string& payload, bool& shutdown) {
+    shutdown = false;
+    std::vector<std::string> words = splitWords(line);
+    if (words.empty()) {
+        return error("empty request");
+    }
+    
+    const std::string& command = words[0];
+    if (command == "PING") {
+        return ok("pong");
+    }
+    if (command == "SHUTDOWN") {
+        shutdown = true;
+        return ok("");
+    }
+    if (command == "STATS") {
+        return ok(Trace::toJson());
+    }
+    if (words.size() < 2) {
+        return error("missing repository name");
+    }
+    
+    const std::string& name = words[1];
+    uint64_t start = Trace::now();
+    bool known = true;
+    RequestReply reply = error("unknown command");
+    bool found = true;
+    
+    // Shared lock: history and content reads
+    if (command == "LOG" || command == "FILES" || command == "CAT" || command == "DIFF" ||
+        command == "BRANCHES" || command == "SEARCH" || command == "GREP") {
+        found = host.withReader(name, [&](const Repository& repo) {
+            if (!repo.isInitialized()) {
+                reply = error("repository not initialized");
+            } else if (command == "LOG") {
+                std::string body;
+                for (Commit* commit : repo.getCommitHistory()) {
+                    body += std::to_string(commit->versionId) + "\t" + commit->getTimestamp() + "\t";
+                    body += commit->message;
+                    body += "\n";
+                }
+                reply = ok(body);
+            } else if (command == "FILES") {
+                std::string body;
+                for (const std::string& file : repo.getWorkingFiles()) {
+                    body += std::to_string(repo.getFileSize(file)) + "\t" + file + "\n";
+                }
+                reply = ok(body);
+            } else if (command == "CAT" && (words.size() == 3 || words.size() == 4)) {
+                int versionId;
+                if (words.size() == 3) {
+                    std::shared_ptr<const std::string> content = repo.getFileBuffer(words[2]);
+                    reply = content ? ok(*content) : error("no such file");
+                } else if (!parseVersion(words[3], versionId) || !repo.getCommitById(versionId)) {
+                    reply = error("no such version");
+                } else {
+                    std::shared_ptr<const std::string> content =
+                        repo.getCommitById(versionId)->getFileBuffer(words[2]);
+                    reply = content ? ok(*content) : error("no such file");
+                }
+            } else if (command == "DIFF" && words.size() == 5) {
+                int fromId, toId;
+                Commit* from = parseVersion(words[3], fromId) ? repo.getCommitById(fromId) : nullptr;
+                Commit* to = parseVersion(words[4], toId) ? repo.getCommitById(toId) : nullptr;
+                if (!from || !to) {
+                    reply = error("no such version");
+                } else {
+                    reply = ok(Diff::unifiedDiff(words[2] + "@" + words[3], words[2] + "@" + words[4],
+                                                 from->getFile(words[2]), to->getFile(words[2])));
+                }
+            } else if (command == "BRANCHES" && words.size() == 2) {
+                std::string body;
+                std::string currentBranch = repo.getCurrentBranch();
+                for (const auto& branch : repo.getBranches()) {
+                    body += (branch.first == currentBranch ? "* " : "  ") + branch.first + "\t";
+                    body += std::to_string(branch.second) + "\n";
+                }
+                reply = ok(body);
+            } else if ((command == "SEARCH" || command == "GREP") && words.size() >= 3) {
+                // The pattern is the rest of the line after the repository name
+                size_t start = line.find(name, line.find(command) + command.size()) + name.size();
+                std::string pattern = line.substr(line.find_first_not_of(' ', start));
+                std::vector<SearchHit> hits;
+                if (!repo.search(pattern, command == "GREP", MAX_SEARCH_HITS, hits)) {
+                    reply = error("bad pattern");
+                } else {
+                    std::string body;
+                    for (const SearchHit& hit : hits) {
+                        body += std::to_string(hit.versionId) + "\t" + hit.path + "\t";
+                        body += std::to_string(hit.lineNumber) + "\t" + hit.line + "\n";
+                    }
+                    reply = ok(body);
+                }
+            } else {
+                reply = error("wrong number of arguments");
+            }
+        });
+    } else if (command == "INIT" || command == "STATUS" || command == "ADD" ||
+               command == "COMMIT" || command == "REVERT" || command == "REPACK" ||
+               command == "BRANCH" || command == "SWITCH" || command == "MERGE") {
+        // Exclusive lock: anything that changes the repository
+        found = host.withWriter(name, [&](Repository& repo) {
+            if (command == "INIT") {
+                reply = repo.initializeRepo() ? ok("") : error("already initialized");
+            } else if (!repo.isInitialized()) {
+                reply = error("repository not initialized");
+            } else if (command == "STATUS") {
+                std::string body;
+                for (const FileChange& change : repo.getStatus()) {
+                    body += (change.status == FILE_ADDED ? "A " : change.status == FILE_REMOVED ? "D " : "M ");
+                    body += change.filename + "\n";
+                }
+                reply = ok(body);
+            } else if (command == "ADD" && words.size() == 4) {
+                reply = repo.addFile(words[2], payload) ? ok("") : error("add failed");
+            } else if (command == "COMMIT" && words.size() >= 3) {
+                // The message is the rest of the line after the repository name
+                size_t start = line.find(name, line.find(command) + command.size()) + name.size();
+                std::string message = line.substr(line.find_first_not_of(' ', start));
+                if (repo.commitChanges(message)) {
+                    reply = ok(std::to_string(repo.getCurrentCommit()->versionId));
+                } else {
+                    reply = error("nothing to commit");
+                }
+            } else if (command == "REVERT" && words.size() == 3) {
+                int versionId;
+                reply = (parseVersion(words[2], versionId) && repo.revertToCommit(versionId))
+                        ? ok("") : error("no such version");
+            } else if (command == "REPACK" && words.size() == 2) {
+                size_t packedCount;
+                reply = repo.repack(packedCount) ? ok(std::to_string(packedCount)) : error("repack failed");
+            } else if (command == "BRANCH" && (words.size() == 3 || words.size() == 4)) {
+                int versionId = -1;
+                if (words.size() == 4 && (!parseVersion(words[3], versionId) || !repo.getCommitById(versionId))) {
+                    reply = error("no such version");
+                } else {
+                    reply = repo.createBranch(words[2], versionId) ? ok("") : error("branch already exists");
+                }
+            } else if (command == "SWITCH" && words.size() == 3) {
+                if (!repo.getBranches().count(words[2])) {
+                    reply = error("no such branch");
+                } else if (repo.isMerging()) {
+                    reply = error("merge in progress");
+                } else {
+                    reply = repo.switchBranch(words[2]) ? ok("") : error("uncommitted changes would be overwritten");
+                }
+            } else if (command == "MERGE" && words.size() == 3) {
+                std::vector<std::string> conflicts;
+                MergeStatus status = MERGE_FAILED;
+                if (!repo.getBranches().count(words[2])) {
+                    reply = error("no such branch");
+                } else if (repo.isMerging()) {
+                    reply = error("merge in progress");
+                } else {
+                    status = repo.mergeBranch(words[2], conflicts);
+                    reply = error("uncommitted changes");
+                }
+                if (status == MERGE_CONFLICTS) {
+                    std::string body;
+                    for (const std::string& file : conflicts) {
+                        body += "conflict " + file + "\n";
+                    }
+                    reply = ok(body);
+                } else if (status == MERGE_UP_TO_DATE) {
+                    reply = ok("up to date");
+                } else if (status != MERGE_FAILED) {
+                    reply = ok((status == MERGE_FAST_FORWARD ? "fast-forward " : "merged ") +
+                               std::to_string(repo.getCurrentCommit()->versionId));
+                }
+            } else {
+                reply = error("wrong number of arguments");
+            }
+        }, command == "INIT");
+    } else {
+        known = false;
+    }
+    
+    if (!found) {
+        return error("no such repository");
+    }
+#ifdef MINIVCS_TRACE
+    // Per command and repository, so the slow repositories stand out
+    if (known) {
+        std::string traceName = "request." + command + "." + name;
+        uint64_t duration = Trace::now() - start;
+        Trace::histogram(traceName).record(duration);
+        if (Trace::isCapturingEvents()) {
+            Trace::recordEvent(traceName, start, duration);
+        }
+    }
+#else
+    (void)start;
+    (void)known;
+#endif
+    return reply;
+}
+
+std::string RequestHandler::formatReply(const RequestReply& reply) {
+    if (!reply.ok) {
+        return "ERR " + reply.body + "\n";
+    }
+    return "OK " + std::to_string(reply.body.size()) + "\n" + reply.body;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef REQUESTHANDLER_H
+#define REQUESTHANDLER_H
+
+#include "RepositoryHost.h"
+#include <string>
+
+struct RequestReply {
+    bool ok;
+    std::string body;       // Reply body, or the reason when not ok
+};
+
+// Executes requests against a RepositoryHost, for the socket server and
+// the batch command line alike. A request is one line, "COMMAND repo
+// args..."; ADD is followed by exactly <size> bytes of content. Every
+// reply is either "OK <length>\n" and <length> bytes of body, or
+// "ERR <reason>\n".
+//
+//   PING                           -> pong
+//   STATS                          latency histograms and counters as JSON (see Trace.h)
+//   INIT repo                      create and initialize a repository
+//   LOG repo                       "<id>\t<timestamp>\t<message>" per commit, newest first
+//   FILES repo                     "<size>\t<name>" per working file
+//   CAT repo file [version]        working or committed content
+//   DIFF repo file from to         unified diff of file between two versions
+//   STATUS repo                    "A <name>" / "M <name>" / "D <name>" per changed file
+//   ADD repo file size             then the content bytes
+//   COMMIT repo message...         -> new version id
+//   REVERT repo version
+//   BRANCHES repo                  "<mark> <name>\t<tip id>" per branch, "*" marking the current one
+//   BRANCH repo name [version]     create a branch at version, or at the current commit
+//   SWITCH repo name               check out a branch, keeping uncommitted edits
+//   MERGE repo name                merge a branch -> "up to date", "fast-forward <id>",
+//                                  "merged <id>", or "conflict <name>" per conflicting file
+//   SEARCH repo text...            "<id>\t<file>\t<line>\t<text>" per committed line containing text,
+//                                  under the commit that introduced it, newest first
+//   GREP repo regex...             the same for lines matching an ECMAScript regular expression
+//   REPACK repo                    move loose commit files into the pack -> commits packed
+//   SHUTDOWN                       stop the server, or end a batch
+//
+// File names and branch names may not contain spaces. LOG, FILES, CAT, DIFF, BRANCHES, SEARCH and
+// GREP take the repository's shared lock; the rest take it exclusively.
+class RequestHandler {
+private:
+    RepositoryHost& host;
+
+public:
+    RequestHandler(RepositoryHost& repositoryHost);
+    
+    // Execute one request; shutdown is set for SHUTDOWN
+    RequestReply handle(const std::string& line, const std::string& payload, bool& shutdown);
+    
+    // Number of content bytes that follow a request line (only ADD has
+    // any); false if the line is malformed
+    static bool getPayloadSize(const std::string& line, size_t& size);
+    
+    // Reply in wire form
+    static std::string formatReply(const RequestReply& reply);
+};
+
+#endif
\ No newline at end of file
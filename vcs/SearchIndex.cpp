@@ -0,0 +1,527 @@
+#include "SearchIndex.h"
+#include "ObjectStore.h"
+#include "BinaryIO.h"
+#include "MappedFile.h"
+#include "FileSync.h"
+#include "LineScanner.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <regex>
+#include <unordered_set>
+#include <sys/stat.h>
+
+// File layout: magic "MVSI", format version, then records, each starting
+// with its type:
+//   blob    id length and id, flags, trigram count and the trigrams
+//   commit  version id, file count, then per file: path length and path,
+//           blob id length and id
+static const char SEARCH_MAGIC[4] = { 'M', 'V', 'S', 'I' };
+static const uint32_t SEARCH_VERSION = 1;
+static const size_t SEARCH_HEADER_SIZE = 8;
+static const uint32_t RECORD_BLOB = 1;
+static const uint32_t RECORD_COMMIT = 2;
+static const uint32_t BLOB_BINARY = 1;
+
+// Longer lines are skipped by regular expression searches: std::regex
+// backtracks recursively and can exhaust the stack on one huge line
+static const size_t MAX_REGEX_LINE = 4096;
+
+SearchIndex::SearchIndex() : loaded(false) {
+}
+
+void SearchIndex::setIndexPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    indexPath = path;
+    blobs.clear();
+    ordinals.clear();
+    postings.clear();
+    indexedCommits.clear();
+    loaded = false;
+}
+
+// Bounds-checked reads for load(); false once the data runs out
+static bool readWord(const char* data, size_t size, size_t& pos, uint32_t& value) {
+    if (size - pos < 4) {
+        return false;
+    }
+    value = readU32(data + pos);
+    pos += 4;
+    return true;
+}
+
+static bool readText(const char* data, size_t size, size_t& pos, std::string& text) {
+    uint32_t length;
+    if (!readWord(data, size, pos, length) || size - pos < length) {
+        return false;
+    }
+    text.assign(data + pos, length);
+    pos += length;
+    return true;
+}
+
+static void appendText(std::string& out, const std::string& text) {
+    appendU32(out, static_cast<uint32_t>(text.size()));
+    out += text;
+}
+
+bool SearchIndex::load() {
+    blobs.clear();
+    ordinals.clear();
+    postings.clear();
+    indexedCommits.clear();
+    loaded = true;
+    
+    MappedFile file;
+    if (!file.open(indexPath)) {
+        return true;    // Nothing indexed yet
+    }
+    const char* data = file.data();
+    size_t size = file.size();
+    if (size < SEARCH_HEADER_SIZE || data[0] != SEARCH_MAGIC[0] || data[1] != SEARCH_MAGIC[1] ||
+        data[2] != SEARCH_MAGIC[2] || data[3] != SEARCH_MAGIC[3] || readU32(data + 4) > SEARCH_VERSION) {
+        // Unreadable: start over, and let the history be indexed again
+        file.close();
+        return std::remove(indexPath.c_str()) == 0;
+    }
+    
+    // Stop at the first incomplete record; a crash can only tear the last one
+    size_t pos = SEARCH_HEADER_SIZE;
+    size_t good = pos;
+    std::vector<uint32_t> trigrams;
+    while (pos < size) {
+        uint32_t type;
+        if (!readWord(data, size, pos, type)) {
+            break;
+        }
+        if (type == RECORD_BLOB) {
+            std::string blobId;
+            uint32_t flags, count;
+            if (!readText(data, size, pos, blobId) || !readWord(data, size, pos, flags) ||
+                !readWord(data, size, pos, count) || (size - pos) / 4 < count) {
+                break;
+            }
+            trigrams.resize(count);
+            for (uint32_t i = 0; i < count; i++) {
+                trigrams[i] = readU32(data + pos + i * 4);
+            }
+            pos += static_cast<size_t>(count) * 4;
+            addBlob(blobId, (flags & BLOB_BINARY) != 0, trigrams);
+        } else if (type == RECORD_COMMIT) {
+            uint32_t versionId, count;
+            // Each file takes at least its two length words
+            if (!readWord(data, size, pos, versionId) || !readWord(data, size, pos, count) ||
+                (size - pos) / 8 < count) {
+                break;
+            }
+            std::vector<std::pair<std::string, std::string>> files(count);
+            bool complete = true;
+            for (uint32_t i = 0; i < count && complete; i++) {
+                complete = readText(data, size, pos, files[i].first) && readText(data, size, pos, files[i].second);
+            }
+            if (!complete) {
+                break;
+            }
+            for (const auto& file : files) {
+                addOccurrence(static_cast<int>(versionId), file.first, file.second);
+            }
+            markIndexed(static_cast<int>(versionId));
+        } else {
+            break;
+        }
+        good = pos;
+    }
+    
+    // Drop the torn tail so later appends follow whole records
+    if (good != size) {
+        std::string kept(data, good);
+        file.close();
+        return FileSync::replaceFile(indexPath, kept, false);
+    }
+    return true;
+}
+
+bool SearchIndex::addCommit(const Commit* commit, ObjectStore* store) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return appendCommit(commit, store);
+}
+
+bool SearchIndex::appendCommit(const Commit* commit, ObjectStore* store) {
+    TRACE_SCOPE("search.indexCommit");
+    if (!commit || commit->versionId <= 0) {
+        return false;
+    }
+    
+    // The files it introduced: changed from its first parent and not taken
+    // unchanged from another (a merge)
+    std::vector<std::pair<std::string, std::string>> files;
+    FileTree::compare(commit->prev ? commit->prev->files : FileTree(), commit->files,
+                      [&](std::string_view path, const FileEntry*, const FileEntry* after) {
+        if (!after) {
+            return;
+        }
+        for (uint32_t i = 1; i < commit->parentCount; i++) {
+            const FileEntry* theirs = commit->parents[i]->files.find(path);
+            if (theirs && theirs->blobId == after->blobId) {
+                return;
+            }
+        }
+        files.emplace_back(std::string(path), std::string(after->blobId));
+    });
+    
+    // New contents are indexed once; before the index is loaded every
+    // content counts as new, and load() keeps the first record of a blob
+    std::string out;
+    std::unordered_set<std::string> written;
+    std::vector<uint32_t> trigrams;
+    for (const auto& file : files) {
+        const std::string& blobId = file.second;
+        if ((loaded && ordinals.count(blobId)) || !written.insert(blobId).second) {
+            continue;
+        }
+        std::string content;
+        if (!store->readBlobUncached(blobId, content)) {
+            continue;
+        }
+        bool binary = content.find('\0') != std::string::npos;
+        trigrams.clear();
+        if (!binary) {
+            collectTrigrams(content, trigrams);
+        }
+        
+        appendU32(out, RECORD_BLOB);
+        appendText(out, blobId);
+        appendU32(out, binary ? BLOB_BINARY : 0);
+        appendU32(out, static_cast<uint32_t>(trigrams.size()));
+        for (uint32_t trigram : trigrams) {
+            appendU32(out, trigram);
+        }
+        if (loaded) {
+            addBlob(blobId, binary, trigrams);
+        }
+    }
+    
+    appendU32(out, RECORD_COMMIT);
+    appendU32(out, static_cast<uint32_t>(commit->versionId));
+    appendU32(out, static_cast<uint32_t>(files.size()));
+    for (const auto& file : files) {
+        appendText(out, file.first);
+        appendText(out, file.second);
+        if (loaded) {
+            addOccurrence(commit->versionId, file.first, file.second);
+        }
+    }
+    if (loaded) {
+        markIndexed(commit->versionId);
+    }
+    
+    // Only a cache, rebuilt from the commits if lost, so it is not synced
+    struct stat info;
+    if (stat(indexPath.c_str(), &info) != 0) {
+        std::string header(SEARCH_MAGIC, 4);
+        appendU32(header, SEARCH_VERSION);
+        out.insert(0, header);
+    }
+    std::ofstream file(indexPath, std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(out.data(), out.size());
+    return file.good();
+}
+
+void SearchIndex::addBlob(const std::string& blobId, bool binary, const std::vector<uint32_t>& trigrams) {
+    if (ordinals.count(blobId)) {
+        return;
+    }
+    uint32_t ordinal = static_cast<uint32_t>(blobs.size());
+    ordinals[blobId] = ordinal;
+    Blob blob;
+    blob.blobId = blobId;
+    blob.binary = binary;
+    blobs.push_back(blob);
+    for (uint32_t trigram : trigrams) {
+        postings[trigram].push_back(ordinal);
+    }
+}
+
+void SearchIndex::addOccurrence(int versionId, const std::string& path, const std::string& blobId) {
+    auto found = ordinals.find(blobId);
+    if (found == ordinals.end()) {
+        return;     // Its content could not be read when the commit was indexed
+    }
+    Occurrence occurrence = { versionId, path };
+    blobs[found->second].occurrences.push_back(occurrence);
+}
+
+void SearchIndex::markIndexed(int versionId) {
+    if (versionId < 0) {
+        return;
+    }
+    if (static_cast<size_t>(versionId) >= indexedCommits.size()) {
+        indexedCommits.resize(static_cast<size_t>(versionId) + 1, false);
+    }
+    indexedCommits[versionId] = true;
+}
+
+bool SearchIndex::search(const std::string& pattern, bool regex, size_t maxHits,
+                         const std::vector<Commit*>& commits, ObjectStore* store, std::vector<SearchHit>& hits) {
+    TRACE_SCOPE("search.query");
+    hits.clear();
+    std::regex expression;
+    if (regex) {
+        try {
+            expression = std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
+        } catch (const std::regex_error&) {
+            return false;
+        }
+    } else if (pattern.empty()) {
+        return true;
+    }
+    
+    // Only the index lookup holds the lock; reading and matching contents
+    // work on a copy of the candidates
+    std::vector<Blob> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!loaded) {
+            load();
+        }
+        for (Commit* commit : commits) {
+            if (commit && commit->versionId > 0 &&
+                (static_cast<size_t>(commit->versionId) >= indexedCommits.size() || !indexedCommits[commit->versionId])) {
+                appendCommit(commit, store);
+            }
+        }
+        
+        std::vector<std::string> literals;
+        requiredLiterals(pattern, regex, literals);
+        std::vector<uint32_t> ordinals = findCandidates(literals);
+        TRACE_COUNT("search.candidates", ordinals.size());
+        for (uint32_t ordinal : ordinals) {
+            if (!blobs[ordinal].binary) {
+                candidates.push_back(blobs[ordinal]);
+            }
+        }
+    }
+    
+    std::vector<std::string_view> lines;
+    for (const Blob& blob : candidates) {
+        // Only occurrences still true of their commit count; a crash may
+        // have left records for a commit that was never completed
+        std::vector<const Occurrence*> occurrences;
+        for (const Occurrence& occurrence : blob.occurrences) {
+            const Commit* commit = static_cast<size_t>(occurrence.versionId) < commits.size()
+                                   ? commits[occurrence.versionId] : nullptr;
+            const FileEntry* file = commit ? commit->files.find(occurrence.path) : nullptr;
+            if (file && file->blobId == blob.blobId) {
+                occurrences.push_back(&occurrence);
+            }
+        }
+        std::string content;
+        if (occurrences.empty() || !store->readBlobUncached(blob.blobId, content)) {
+            continue;
+        }
+        
+        // Matching lines of this content, by number
+        std::vector<std::pair<int, std::string_view>> matches;
+        if (regex) {
+            LineScanner::splitLines(content, lines);
+            for (size_t i = 0; i < lines.size(); i++) {
+                std::string_view line = lines[i];
+                if (!line.empty() && line.back() == '\n') {
+                    line.remove_suffix(1);
+                }
+                if (line.size() <= MAX_REGEX_LINE && std::regex_search(line.begin(), line.end(), expression)) {
+                    matches.emplace_back(static_cast<int>(i + 1), line);
+                }
+            }
+        } else {
+            size_t lineNumber = 1;
+            size_t counted = 0;
+            size_t found = content.find(pattern);
+            while (found != std::string::npos) {
+                size_t lineStart = content.rfind('\n', found);
+                lineStart = (lineStart == std::string::npos) ? 0 : lineStart + 1;
+                size_t lineEnd = content.find('\n', found + pattern.size() - 1);
+                lineEnd = (lineEnd == std::string::npos) ? content.size() : lineEnd;
+                lineNumber += LineScanner::countNewlines(content.data() + counted, lineStart - counted);
+                counted = lineStart;
+                matches.emplace_back(static_cast<int>(lineNumber),
+                                     std::string_view(content.data() + lineStart, lineEnd - lineStart));
+                found = (lineEnd < content.size()) ? content.find(pattern, lineEnd + 1) : std::string::npos;
+            }
+        }
+        
+        for (const Occurrence* occurrence : occurrences) {
+            for (const auto& match : matches) {
+                SearchHit hit;
+                hit.versionId = occurrence->versionId;
+                hit.path = occurrence->path;
+                hit.lineNumber = match.first;
+                hit.line.assign(match.second.data(), match.second.size());
+                hits.push_back(hit);
+            }
+        }
+    }
+    
+    std::sort(hits.begin(), hits.end(), [](const SearchHit& a, const SearchHit& b) {
+        if (a.versionId != b.versionId) {
+            return a.versionId > b.versionId;
+        }
+        if (a.path != b.path) {
+            return a.path < b.path;
+        }
+        return a.lineNumber < b.lineNumber;
+    });
+    if (hits.size() > maxHits) {
+        hits.resize(maxHits);
+    }
+    return true;
+}
+
+std::vector<uint32_t> SearchIndex::findCandidates(const std::vector<std::string>& literals) const {
+    std::vector<uint32_t> trigrams;
+    for (const std::string& literal : literals) {
+        collectTrigrams(literal, trigrams);
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    
+    std::vector<uint32_t> candidates;
+    if (trigrams.empty()) {
+        // Nothing to filter on: every content is a candidate
+        candidates.resize(blobs.size());
+        for (uint32_t i = 0; i < candidates.size(); i++) {
+            candidates[i] = i;
+        }
+        return candidates;
+    }
+    
+    // Intersect the posting lists, shortest first
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (uint32_t trigram : trigrams) {
+        auto found = postings.find(trigram);
+        if (found == postings.end()) {
+            return candidates;
+        }
+        lists.push_back(&found->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) { return a->size() < b->size(); });
+    candidates = *lists[0];
+    std::vector<uint32_t> kept;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        kept.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(kept));
+        candidates.swap(kept);
+    }
+    return candidates;
+}
+
+void SearchIndex::collectTrigrams(const std::string& content, std::vector<uint32_t>& trigrams) {
+    // Appends; the caller sorts out duplicates across calls
+    size_t first = trigrams.size();
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(content.data());
+    for (size_t i = 0; i + 3 <= content.size(); i++) {
+        trigrams.push_back((static_cast<uint32_t>(bytes[i]) << 16) | (static_cast<uint32_t>(bytes[i + 1]) << 8) |
+                           bytes[i + 2]);
+    }
+    std::sort(trigrams.begin() + first, trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin() + first, trigrams.end()), trigrams.end());
+}
+
+// Last character of the escape whose letter is at pattern[i]
+static size_t escapeEnd(const std::string& pattern, size_t i) {
+    char letter = pattern[i];
+    size_t limit = 0;
+    if (letter == 'x') {
+        limit = 2;
+    } else if (letter == 'u') {
+        limit = 4;
+    } else if (letter == 'c') {
+        limit = 1;
+    } else if (std::isdigit(static_cast<unsigned char>(letter))) {
+        limit = pattern.size();     // \0 octal escapes and back references
+    }
+    auto accepts = [letter](unsigned char next) {
+        if (letter == 'x' || letter == 'u') {
+            return std::isxdigit(next) != 0;
+        }
+        return (letter == 'c') ? std::isalpha(next) != 0 : std::isdigit(next) != 0;
+    };
+    for (size_t taken = 0; taken < limit && i + 1 < pattern.size() &&
+         accepts(static_cast<unsigned char>(pattern[i + 1])); taken++) {
+        i++;
+    }
+    return i;
+}
+
+void SearchIndex::requiredLiterals(const std::string& pattern, bool regex, std::vector<std::string>& literals) {
+    literals.clear();
+    if (!regex) {
+        literals.push_back(pattern);
+        return;
+    }
+    
+    // Runs of plain characters outside groups and classes must appear in
+    // any match. A character made optional by ?, * or {..} is dropped from
+    // its run; an alternation at the top level means nothing is required.
+    std::string run;
+    auto flush = [&]() {
+        if (run.size() >= 3) {
+            literals.push_back(run);
+        }
+        run.clear();
+    };
+    for (size_t i = 0; i < pattern.size(); i++) {
+        char c = pattern[i];
+        if (c == '\\' && i + 1 < pattern.size()) {
+            char escaped = pattern[++i];
+            if (std::isalnum(static_cast<unsigned char>(escaped))) {
+                // \d, \w, \b, \n and the like; \x, \u, \c and numeric
+                // escapes also take the characters after their letter
+                i = escapeEnd(pattern, i);
+                flush();
+            } else {
+                run += escaped;
+            }
+        } else if (c == '|') {
+            literals.clear();
+            return;
+        } else if (c == '*' || c == '?' || c == '{') {
+            if (!run.empty()) {
+                run.pop_back();
+            }
+            flush();
+            if (c == '{') {
+                while (i < pattern.size() && pattern[i] != '}') {
+                    i++;
+                }
+            }
+        } else if (c == '(' || c == '[') {
+            // Skip the group or class; its contents are not required as written
+            flush();
+            int depth = 0;
+            char open = c;
+            char close = (c == '(') ? ')' : ']';
+            for (; i < pattern.size(); i++) {
+                if (pattern[i] == '\\') {
+                    i++;
+                } else if (pattern[i] == open && (open == '(' || depth == 0)) {
+                    depth++;
+                } else if (pattern[i] == close && --depth == 0) {
+                    break;
+                }
+            }
+        } else if (c == '.' || c == '^' || c == '$' || c == '+' || c == ')' || c == ']' || c == '}') {
+            flush();
+        } else {
+            run += c;
+        }
+    }
+    flush();
+}
\ No newline at end of file
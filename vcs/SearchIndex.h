@@ -0,0 +1,78 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include "Commit.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// A line that matched a search
+struct SearchHit {
+    int versionId;          // Commit that introduced the content at this path
+    std::string path;
+    int lineNumber;         // 1-based
+    std::string line;       // Without its newline
+};
+
+// Trigram index over every committed file content, kept in
+// <dataPath>/search.bin. Each distinct blob is indexed once, under every
+// three-byte sequence it contains, and each commit records the files it
+// introduced. A query only reads blobs holding all of the trigrams the
+// pattern requires, then reports the matching lines under each commit that
+// introduced one of them.
+//
+// The file is an append-only cache. Commits are appended as they are made
+// and, for history from before the index, on the first search; hits are
+// checked against the commit before they are reported, so records left by
+// a crashed commit do no harm. All methods are safe to call concurrently.
+class SearchIndex {
+private:
+    struct Occurrence {
+        int versionId;
+        std::string path;
+    };
+    struct Blob {
+        std::string blobId;
+        bool binary;                        // Holds a NUL byte; never searched
+        std::vector<Occurrence> occurrences;
+    };
+    
+    std::string indexPath;
+    std::vector<Blob> blobs;                // Ordinal -> blob
+    std::unordered_map<std::string, uint32_t> ordinals;                 // blob id -> ordinal
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings;       // trigram -> ascending ordinals
+    std::vector<bool> indexedCommits;       // version id -> recorded
+    bool loaded;
+    mutable std::mutex mutex;
+
+public:
+    SearchIndex();
+    
+    void setIndexPath(const std::string& path);
+    
+    // Record the files a new commit introduced. Cheap when the index has not
+    // been loaded: the records are only appended to the file.
+    bool addCommit(const Commit* commit, ObjectStore* store);
+    
+    // Lines matching pattern, newest commit first, at most maxHits of them.
+    // commits maps version ids to commits; any not yet indexed are indexed
+    // first. With regex, pattern is an ECMAScript regular expression and
+    // false means it did not parse; lines over 4096 bytes are not matched.
+    bool search(const std::string& pattern, bool regex, size_t maxHits,
+                const std::vector<Commit*>& commits, ObjectStore* store, std::vector<SearchHit>& hits);
+
+private:
+    bool load();
+    bool appendCommit(const Commit* commit, ObjectStore* store);
+    void addBlob(const std::string& blobId, bool binary, const std::vector<uint32_t>& trigrams);
+    void addOccurrence(int versionId, const std::string& path, const std::string& blobId);
+    void markIndexed(int versionId);
+    std::vector<uint32_t> findCandidates(const std::vector<std::string>& literals) const;
+    
+    static void collectTrigrams(const std::string& content, std::vector<uint32_t>& trigrams);
+    static void requiredLiterals(const std::string& pattern, bool regex, std::vector<std::string>& literals);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "Sha1.h"
+#include <cstring>
+
+static inline uint32_t rotateLeft(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+Sha1::Sha1() : totalLength(0), bufferLength(0) {
+    state[0] = 0x67452301;
+    state[1] = 0xEFCDAB89;
+    state[2] = 0x98BADCFE;
+    state[3] = 0x10325476;
+    state[4] = 0xC3D2E1F0;
+}
+
+void Sha1::update(const char* data, size_t length) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    totalLength += length;
+    
+    // Top up a partially filled block first
+    if (bufferLength > 0) {
+        size_t take = 64 - bufferLength;
+        if (take > length) take = length;
+        memcpy(buffer + bufferLength, bytes, take);
+        bufferLength += take;
+        bytes += take;
+        length -= take;
+        if (bufferLength == 64) {
+            processBlock(buffer);
+            bufferLength = 0;
+        }
+    }
+    
+    // Hash full blocks straight from the input
+    while (length >= 64) {
+        processBlock(bytes);
+        bytes += 64;
+        length -= 64;
+    }
+    
+    if (length > 0) {
+        memcpy(buffer, bytes, length);
+        bufferLength = length;
+    }
+}
+
+void Sha1::update(const std::string& data) {
+    update(data.data(), data.size());
+}
+
+std::string Sha1::hexDigest() {
+    uint64_t bitLength = totalLength * 8;
+    
+    // Padding: 0x80, zeros, then the 64-bit big endian message length
+    unsigned char padding[72];
+    size_t padLength = (bufferLength < 56) ? (56 - bufferLength) : (120 - bufferLength);
+    memset(padding, 0, sizeof(padding));
+    padding[0] = 0x80;
+    for (int i = 0; i < 8; i++) {
+        padding[padLength + i] = static_cast<unsigned char>(bitLength >> (56 - 8 * i));
+    }
+    update(reinterpret_cast<const char*>(padding), padLength + 8);
+    
+    static const char hexChars[] = "0123456789abcdef";
+    std::string digest;
+    digest.reserve(40);
+    for (int i = 0; i < 5; i++) {
+        for (int shift = 28; shift >= 0; shift -= 4) {
+            digest += hexChars[(state[i] >> shift) & 0xF];
+        }
+    }
+    return digest;
+}
+
+std::string Sha1::hash(const std::string& data) {
+    return hash(data.data(), data.size());
+}
+
+std::string Sha1::hash(const char* data, size_t length) {
+    Sha1 sha;
+    sha.update(data, length);
+    return sha.hexDigest();
+}
+
+void Sha1::processBlock(const unsigned char* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+               (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+               static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+    
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
\ No newline at end of file
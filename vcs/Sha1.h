@@ -0,0 +1,31 @@
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Minimal SHA-1 implementation used to name objects by their content
+class Sha1 {
+private:
+    uint32_t state[5];
+    unsigned char buffer[64];
+    uint64_t totalLength;
+    size_t bufferLength;
+    
+public:
+    Sha1();
+    
+    void update(const char* data, size_t length);
+    void update(const std::string& data);
+    std::string hexDigest();
+    
+    // One-shot helper: 40 character lowercase hex digest of data
+    static std::string hash(const std::string& data);
+    static std::string hash(const char* data, size_t length);
+    
+private:
+    void processBlock(const unsigned char* block);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "StringPool.h"
+#include <functional>
+
+std::string_view StringPool::intern(std::string_view text) {
+    size_t hash = std::hash<std::string_view>()(text);
+    Shard& shard = shards[(hash >> 8) % SHARD_COUNT];
+    
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.strings.find(text);
+    if (it != shard.strings.end()) {
+        return *it;
+    }
+    std::string_view copy = shard.arena.copyString(text);
+    shard.strings.insert(copy);
+    return copy;
+}
+
+void StringPool::clear() {
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.strings.clear();
+        shard.arena.release();
+    }
+}
\ No newline at end of file
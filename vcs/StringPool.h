@@ -0,0 +1,36 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include "Arena.h"
+#include <string_view>
+#include <unordered_set>
+#include <mutex>
+#include <cstddef>
+
+// Interned strings shared by a repository's commits (paths and blob ids).
+// Each distinct string is stored once and commits hold views of that copy,
+// so a path that appears in every commit costs its characters only once.
+// Interning may run on several threads at once: the pool is split into
+// shards by hash, each with its own lock and arena.
+class StringPool {
+private:
+    struct Shard {
+        std::mutex mutex;
+        Arena arena;
+        std::unordered_set<std::string_view> strings;
+    };
+    
+    static const size_t SHARD_COUNT = 16;
+    Shard shards[SHARD_COUNT];
+
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    
+    // The pool's copy of text; valid until clear()
+    std::string_view intern(std::string_view text);
+    void clear();
+};
+
+#endif
\ No newline at end of file
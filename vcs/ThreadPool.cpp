@@ -0,0 +1,134 @@
+#include "ThreadPool.h"
+
+// Pool and deque index of the calling worker thread, if it is one
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(unsigned threadCount)
+    : queuedTasks(0), unfinishedTasks(0), nextQueue(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = getDefaultThreadCount();
+    }
+    
+    queues.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, static_cast<size_t>(i)));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Workers keep their own follow-up work; other callers spread it round-robin
+    size_t index = (currentPool == this) ? currentWorker : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queuedTasks++;
+        unfinishedTasks++;
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return unfinishedTasks == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    
+    // A few chunks per thread leaves room for stealing to even out the load
+    size_t chunks = static_cast<size_t>(getThreadCount()) * 4;
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        size_t end = (count - begin < chunkSize) ? count : begin + chunkSize;
+        submit([&body, begin, end] { body(begin, end); });
+    }
+    wait();
+}
+
+unsigned ThreadPool::getThreadCount() const {
+    return static_cast<unsigned>(workers.size());
+}
+
+unsigned ThreadPool::getDefaultThreadCount() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    
+    std::function<void()> task;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            workAvailable.wait(lock, [this] { return stopping || queuedTasks > 0; });
+            if (queuedTasks == 0) {
+                return; // Stopping with nothing left to run
+            }
+            queuedTasks--;
+        }
+        
+        // A task is reserved for this worker, so one of the deques holds it
+        while (!takeTask(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+        task = nullptr;
+        
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            finished = (--unfinishedTasks == 0);
+        }
+        if (finished) {
+            allDone.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::takeTask(size_t index, std::function<void()>& task) {
+    // Own deque first, newest task (still warm in cache)
+    {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    
+    // Then steal the oldest task from another worker
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        WorkerQueue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
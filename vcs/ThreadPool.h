@@ -0,0 +1,58 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+
+// Fixed set of worker threads with one task deque each. A worker takes
+// work from the back of its own deque and, once that is empty, steals from
+// the front of the others', so uneven tasks still keep every core busy.
+// Tasks submitted from a worker go to that worker's own deque.
+class ThreadPool {
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t queuedTasks;     // Submitted, not yet taken (guarded by stateMutex)
+    size_t unfinishedTasks; // Submitted, not yet finished (guarded by stateMutex)
+    std::atomic<size_t> nextQueue;
+    bool stopping;
+
+public:
+    // threadCount 0 uses one thread per hardware thread
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+    
+    void submit(std::function<void()> task);
+    
+    // Block until every submitted task has finished. Not for use inside a task.
+    void wait();
+    
+    // Run body(begin, end) over [0, count) split into chunks, and wait for all of them
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body);
+    
+    unsigned getThreadCount() const;
+    static unsigned getDefaultThreadCount();
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+    void workerLoop(size_t index);
+    bool takeTask(size_t index, std::function<void()>& task);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "Trace.h"
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+// Position of the highest set bit; value must not be 0
+static int highestBit(uint64_t value) {
+    int bit = 0;
+    for (int shift = 32; shift > 0; shift >>= 1) {
+        if (value >> shift) {
+            value >>= shift;
+            bit += shift;
+        }
+    }
+    return bit;
+}
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    buckets[bucketFor(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    
+    uint64_t seen = max.load(std::memory_order_relaxed);
+    while (nanoseconds > seen && !max.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (std::atomic<uint64_t>& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getMax() const {
+    return max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMean() const {
+    uint64_t total = getCount();
+    return total ? static_cast<double>(sum.load(std::memory_order_relaxed)) / total : 0.0;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const {
+    uint64_t total = getCount();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+    rank = std::max<uint64_t>(1, std::min(rank, total));
+    
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // The bucket bound may overshoot the largest value actually seen
+            return std::min(bucketUpperBound(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t value) {
+    // Values below SUB_BUCKETS get a bucket each; above, each power of two
+    // is split into SUB_BUCKETS equal parts
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = highestBit(value);
+    size_t subBucket = static_cast<size_t>(value >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int exponent = static_cast<int>(bucket / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    uint64_t subBucket = bucket % SUB_BUCKETS;
+    int shift = exponent - SUB_BUCKET_BITS;
+    return ((SUB_BUCKETS + subBucket + 1) << shift) - 1;
+}
+
+
+struct TraceEvent {
+    std::string name;
+    uint64_t start;
+    uint64_t duration;
+    size_t thread;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms;
+    std::map<std::string, std::unique_ptr<std::atomic<uint64_t>>> counters;
+    
+    std::mutex eventMutex;
+    std::atomic<bool> capturing{false};
+    size_t maxEvents = 0;
+    size_t droppedEvents = 0;
+    std::vector<TraceEvent> events;
+};
+
+// Constructed on first use, so instrumentation in static initializers works
+static TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+static void appendJsonString(std::ostringstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                << std::dec << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+LatencyHistogram& Trace::histogram(const std::string& name) {
+    TraceRegistry& traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    std::unique_ptr<LatencyHistogram>& slot = traces.histograms[name];
+    if (!slot) {
+        slot.reset(new LatencyHistogram());
+    }
+    return *slot;
+}
+
+std::atomic<uint64_t>& Trace::counter(const std::string& name) {
+    TraceRegistry& traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    std::unique_ptr<std::atomic<uint64_t>>& slot = traces.counters[name];
+    if (!slot) {
+        slot.reset(new std::atomic<uint64_t>(0));
+    }
+    return *slot;
+}
+
+void Trace::setCaptureEvents(bool capture, size_t maxEvents) {
+    TraceRegistry& traces = registry();
+    std::lock_guard<std::mutex> lock(traces.eventMutex);
+    traces.maxEvents = maxEvents;
+    traces.capturing.store(capture, std::memory_order_relaxed);
+}
+
+bool Trace::isCapturingEvents() {
+    return registry().capturing.load(std::memory_order_relaxed);
+}
+
+void Trace::recordEvent(std::string_view name, uint64_t startNanoseconds, uint64_t durationNanoseconds) {
+    TraceRegistry& traces = registry();
+    size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::lock_guard<std::mutex> lock(traces.eventMutex);
+    if (traces.events.size() >= traces.maxEvents) {
+        traces.droppedEvents++;
+        return;
+    }
+    traces.events.push_back({ std::string(name), startNanoseconds, durationNanoseconds, thread });
+}
+
+uint64_t Trace::now() {
+    // Relative to the first call, which keeps trace timestamps small
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - origin).count());
+}
+
+std::string Trace::toJson() {
+    TraceRegistry& traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    std::ostringstream out;
+    out << "{\n  \"histograms\": {";
+    bool first = true;
+    for (const auto& entry : traces.histograms) {
+        const LatencyHistogram& histogram = *entry.second;
+        out << (first ? "\n    " : ",\n    ");
+        appendJsonString(out, entry.first);
+        out << ": {\"count\": " << histogram.getCount()
+            << ", \"mean_ns\": " << static_cast<uint64_t>(histogram.getMean())
+            << ", \"p50_ns\": " << histogram.getPercentile(50)
+            << ", \"p90_ns\": " << histogram.getPercentile(90)
+            << ", \"p99_ns\": " << histogram.getPercentile(99)
+            << ", \"p999_ns\": " << histogram.getPercentile(99.9)
+            << ", \"max_ns\": " << histogram.getMax() << "}";
+        first = false;
+    }
+    out << (first ? "},\n" : "\n  },\n") << "  \"counters\": {";
+    first = true;
+    for (const auto& entry : traces.counters) {
+        out << (first ? "\n    " : ",\n    ");
+        appendJsonString(out, entry.first);
+        out << ": " << entry.second->load(std::memory_order_relaxed);
+        first = false;
+    }
+    out << (first ? "}\n" : "\n  }\n") << "}\n";
+    return out.str();
+}
+
+bool Trace::writeChromeTrace(const std::string& path) {
+    TraceRegistry& traces = registry();
+    std::ostringstream out;
+    {
+        std::lock_guard<std::mutex> lock(traces.eventMutex);
+        // Complete ("X") events; the format wants microseconds
+        out << "{\"traceEvents\": [";
+        for (size_t i = 0; i < traces.events.size(); i++) {
+            const TraceEvent& event = traces.events[i];
+            out << (i ? ",\n" : "\n") << "{\"name\": ";
+            appendJsonString(out, event.name);
+            out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << (event.thread % 1000000)
+                << std::fixed << std::setprecision(3)
+                << ", \"ts\": " << event.start / 1000.0 << ", \"dur\": " << event.duration / 1000.0 << "}";
+        }
+        out << "\n], \"otherData\": {\"droppedEvents\": " << traces.droppedEvents << "}}\n";
+    }
+    
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string text = out.str();
+    file.write(text.data(), text.size());
+    return file.good();
+}
+
+void Trace::reset() {
+    TraceRegistry& traces = registry();
+    {
+        std::lock_guard<std::mutex> lock(traces.mutex);
+        for (auto& entry : traces.histograms) {
+            entry.second->reset();
+        }
+        for (auto& entry : traces.counters) {
+            entry.second->store(0, std::memory_order_relaxed);
+        }
+    }
+    std::lock_guard<std::mutex> lock(traces.eventMutex);
+    traces.events.clear();
+    traces.droppedEvents = 0;
+}
+
+
+ScopedTimer::ScopedTimer(LatencyHistogram& target, std::string_view scopeName)
+    : histogram(target), name(scopeName), start(Trace::now()) {
+}
+
+ScopedTimer::~ScopedTimer() {
+    uint64_t duration = Trace::now() - start;
+    histogram.record(duration);
+    if (Trace::isCapturingEvents()) {
+        Trace::recordEvent(name, start, duration);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Latency histogram with HDR-style buckets: 16 linear sub-buckets per
+// power of two, so any recorded value is reported within 6.25% of itself
+// from 1 ns to centuries. Recording is a few relaxed atomic adds and is
+// safe from any thread.
+class LatencyHistogram {
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+    
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+
+public:
+    LatencyHistogram();
+    
+    void record(uint64_t nanoseconds);
+    void reset();
+    
+    uint64_t getCount() const;
+    uint64_t getMax() const;
+    double getMean() const;
+    
+    // Upper bound of the bucket holding the given percentile (0-100)
+    uint64_t getPercentile(double percentile) const;
+
+private:
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+    static size_t bucketFor(uint64_t value);
+    static uint64_t bucketUpperBound(size_t bucket);
+};
+
+// Process-wide registry of named latency histograms and counters, plus an
+// optional capture of individual timed scopes for chrome://tracing.
+// Histograms and counters are never removed, so references to them stay
+// valid for the life of the process.
+class Trace {
+public:
+    static LatencyHistogram& histogram(const std::string& name);
+    static std::atomic<uint64_t>& counter(const std::string& name);
+    
+    // Keep each timed scope as an event, up to maxEvents; later ones are dropped
+    static void setCaptureEvents(bool capture, size_t maxEvents = 1000000);
+    static bool isCapturingEvents();
+    static void recordEvent(std::string_view name, uint64_t startNanoseconds, uint64_t durationNanoseconds);
+    
+    // Monotonic clock in nanoseconds
+    static uint64_t now();
+    
+    // Every histogram (count, mean, percentiles, max) and counter as JSON
+    static std::string toJson();
+    // Captured events in the Chrome trace event format
+    static bool writeChromeTrace(const std::string& path);
+    
+    // Zero every histogram and counter and drop captured events
+    static void reset();
+};
+
+// Records the lifetime of a scope into a histogram, and as an event while
+// events are captured. name must outlive the timer.
+class ScopedTimer {
+private:
+    LatencyHistogram& histogram;
+    std::string_view name;
+    uint64_t start;
+
+public:
+    ScopedTimer(LatencyHistogram& target, std::string_view scopeName);
+    ~ScopedTimer();
+
+private:
+    ScopedTimer(const ScopedTimer&);
+    ScopedTimer& operator=(const ScopedTimer&);
+};
+
+// Instrumentation points compile to nothing unless MINIVCS_TRACE is
+// defined. Each point looks its histogram or counter up once.
+#ifdef MINIVCS_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) \
+    static LatencyHistogram& TRACE_CONCAT(traceHistogram, __LINE__) = Trace::histogram(name); \
+    ScopedTimer TRACE_CONCAT(traceTimer, __LINE__)(TRACE_CONCAT(traceHistogram, __LINE__), name)
+#define TRACE_COUNT(name, amount) \
+    do { \
+        static std::atomic<uint64_t>& traceCounter = Trace::counter(name); \
+        traceCounter.fetch_add(static_cast<uint64_t>(amount), std::memory_order_relaxed); \
+    } while (0)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_COUNT(name, amount) do {} while (0)
+#endif
+
+#endif
\ No newline at end of file
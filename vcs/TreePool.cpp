@@ -0,0 +1,172 @@
+#include "TreePool.h"
+#include <algorithm>
+#include <cstring>
+
+static void mixHash(size_t& hash, size_t value) {
+    hash ^= value + static_cast<size_t>(0x9e3779b97f4a7c15ULL) + (hash << 6) + (hash >> 2);
+}
+
+// Children are hash-consed and strings interned, so comparing pointers is enough
+static bool sameEntries(const TreeNode* node, const std::vector<TreeEntry>& entries) {
+    if (node->entryCount != entries.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        const TreeEntry& a = node->entries[i];
+        const TreeEntry& b = entries[i];
+        if (a.name.data() != b.name.data() || a.name.size() != b.name.size() || a.subtree != b.subtree) {
+            return false;
+        }
+        if (!a.subtree && (a.file.blobId.data() != b.file.blobId.data() || a.file.size != b.file.size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Grouping by directory needs the edits in path order
+static void sortEdits(std::vector<TreeEdit>& edits) {
+    auto byPath = [](const TreeEdit& a, const TreeEdit& b) { return a.path < b.path; };
+    if (!std::is_sorted(edits.begin(), edits.end(), byPath)) {
+        std::stable_sort(edits.begin(), edits.end(), byPath);
+    }
+}
+
+FileTree TreePool::apply(const FileTree& base, std::vector<TreeEdit>& edits) {
+    sortEdits(edits);
+    return FileTree(applyEdits(base.getRoot(), edits.data(), edits.data() + edits.size(), 0, false));
+}
+
+FileTree TreePool::build(std::vector<TreeEdit>& files, const FileTree& similar) {
+    sortEdits(files);
+    return FileTree(applyEdits(similar.getRoot(), files.data(), files.data() + files.size(), 0, true));
+}
+
+std::string_view TreePool::intern(std::string_view text) {
+    return strings.intern(text);
+}
+
+void TreePool::clear() {
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.nodes.clear();
+        shard.arena.release();
+    }
+    strings.clear();
+}
+
+const TreeNode* TreePool::applyEdits(const TreeNode* base, const TreeEdit* begin, const TreeEdit* end,
+                                     size_t offset, bool replace) {
+    uint32_t baseCount = base ? base->entryCount : 0;
+    uint32_t baseIndex = 0;
+    std::vector<TreeEntry> entries;
+    entries.reserve(baseCount + (end - begin));
+    
+    const TreeEdit* edit = begin;
+    while (edit != end) {
+        // The next group: all edits of one file, or all edits below one directory
+        std::string_view path = edit->path;
+        size_t slash = path.find('/', offset);
+        bool isDirectory = (slash != std::string_view::npos);
+        std::string_view name = path.substr(offset, isDirectory ? slash - offset : std::string_view::npos);
+        
+        const TreeEdit* groupEnd = edit + 1;
+        if (isDirectory) {
+            std::string_view prefix = path.substr(0, slash + 1);
+            while (groupEnd != end && groupEnd->path.substr(0, prefix.size()) == prefix) {
+                ++groupEnd;
+            }
+        } else {
+            while (groupEnd != end && groupEnd->path == path) {
+                ++groupEnd;
+            }
+        }
+        
+        // Untouched entries before the group are kept as they are
+        while (baseIndex < baseCount) {
+            const TreeEntry& entry = base->entries[baseIndex];
+            if (FileTree::compareNames(entry.name, entry.subtree != nullptr, name, isDirectory) >= 0) {
+                break;
+            }
+            if (!replace) {
+                entries.push_back(entry);
+            }
+            baseIndex++;
+        }
+        const TreeEntry* existing = nullptr;
+        if (baseIndex < baseCount) {
+            const TreeEntry& entry = base->entries[baseIndex];
+            if ((entry.subtree != nullptr) == isDirectory && entry.name == name) {
+                existing = &entry;
+                baseIndex++;
+            }
+        }
+        
+        const TreeEdit& last = *(groupEnd - 1);
+        if (isDirectory) {
+            // A directory left empty disappears
+            const TreeNode* subtree = applyEdits(existing ? existing->subtree : nullptr, edit, groupEnd,
+                                                 slash + 1, replace);
+            if (subtree) {
+                TreeEntry updated = { existing ? existing->name : strings.intern(name), subtree, FileEntry() };
+                entries.push_back(updated);
+            }
+        } else if (existing && !last.remove && existing->file.size == last.file.size &&
+                   existing->file.blobId == last.file.blobId) {
+            entries.push_back(*existing);
+        } else if (!last.remove) {
+            FileEntry file = { strings.intern(last.file.blobId), last.file.size };
+            TreeEntry updated = { existing ? existing->name : strings.intern(name), nullptr, file };
+            entries.push_back(updated);
+        }
+        edit = groupEnd;
+    }
+    if (base && !replace) {
+        entries.insert(entries.end(), base->entries + baseIndex, base->entries + baseCount);
+    }
+    
+    if (entries.empty()) {
+        return nullptr;
+    }
+    // Unchanged: no need to hash the entries to find the node again
+    if (base && sameEntries(base, entries)) {
+        return base;
+    }
+    return makeNode(entries);
+}
+
+const TreeNode* TreePool::makeNode(const std::vector<TreeEntry>& entries) {
+    size_t hash = entries.size();
+    size_t fileCount = 0;
+    for (const TreeEntry& entry : entries) {
+        mixHash(hash, reinterpret_cast<size_t>(entry.name.data()));
+        if (entry.subtree) {
+            mixHash(hash, reinterpret_cast<size_t>(entry.subtree));
+            fileCount += entry.subtree->fileCount;
+        } else {
+            mixHash(hash, reinterpret_cast<size_t>(entry.file.blobId.data()));
+            mixHash(hash, entry.file.size);
+            fileCount++;
+        }
+    }
+    
+    Shard& shard = shards[(hash >> 8) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto range = shard.nodes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (sameEntries(it->second, entries)) {
+            return it->second;
+        }
+    }
+    
+    TreeEntry* copy = static_cast<TreeEntry*>(shard.arena.allocate(entries.size() * sizeof(TreeEntry),
+                                                                   alignof(TreeEntry)));
+    memcpy(copy, entries.data(), entries.size() * sizeof(TreeEntry));
+    TreeNode* node = shard.arena.create<TreeNode>();
+    node->hash = hash;
+    node->fileCount = fileCount;
+    node->entryCount = static_cast<uint32_t>(entries.size());
+    node->entries = copy;
+    shard.nodes.emplace(hash, node);
+    return node;
+}
\ No newline at end of file
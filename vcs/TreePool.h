@@ -0,0 +1,57 @@
+#ifndef TREEPOOL_H
+#define TREEPOOL_H
+
+#include "FileTree.h"
+#include "StringPool.h"
+#include "Arena.h"
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+// Builds and owns the directory trees of a repository's commits. Every
+// node is hash-consed: a directory whose entries match an existing node is
+// that node, so a subtree left unchanged by a commit is shared with its
+// parent by a single pointer. Path components and blob ids are interned
+// in the pool's StringPool. Safe to use from several threads at once.
+class TreePool {
+private:
+    struct Shard {
+        std::mutex mutex;
+        Arena arena;
+        std::unordered_multimap<size_t, const TreeNode*> nodes;    // hash -> node
+    };
+    
+    static const size_t SHARD_COUNT = 16;
+    Shard shards[SHARD_COUNT];
+    StringPool strings;
+
+public:
+    TreePool() = default;
+    TreePool(const TreePool&) = delete;
+    TreePool& operator=(const TreePool&) = delete;
+    
+    // The tree with the edits applied. Edits may come in any order; the
+    // last edit of a path wins. Only directories on an edited path are
+    // rebuilt.
+    FileTree apply(const FileTree& base, std::vector<TreeEdit>& edits);
+    
+    // The tree holding exactly these files. similar is only a hint: a tree
+    // likely to share most directories with the result, such as the parent
+    // commit's. Directories that match it are reused without rehashing.
+    FileTree build(std::vector<TreeEdit>& files, const FileTree& similar = FileTree());
+    
+    // The pool's copy of a string; valid until clear()
+    std::string_view intern(std::string_view text);
+    
+    // Free every tree and string; trees handed out before are invalid
+    void clear();
+
+private:
+    // With replace set, base entries no edit names are dropped instead of kept
+    const TreeNode* applyEdits(const TreeNode* base, const TreeEdit* begin, const TreeEdit* end,
+                               size_t offset, bool replace);
+    const TreeNode* makeNode(const std::vector<TreeEntry>& entries);
+};
+
+#endif
\ No newline at end of file
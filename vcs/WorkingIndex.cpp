@@ -0,0 +1,154 @@
+#include "WorkingIndex.h"
+#include "BinaryIO.h"
+#include "MappedFile.h"
+#include "FileSync.h"
+
+// File layout: magic "MVWI", format version, base commit id, entry count,
+// then per entry: path length and path, size, mtime, blob id length and id,
+// and (from version 2) flags.
+static const char WORKING_INDEX_MAGIC[4] = { 'M', 'V', 'W', 'I' };
+static const uint32_t WORKING_INDEX_VERSION = 2;
+static const uint32_t WORKING_ENTRY_REMOVED = 1;
+static const size_t WORKING_INDEX_HEADER_SIZE = 16;
+static const size_t WORKING_ENTRY_MIN_SIZE = 24;    // Empty path and blob id, no flags
+
+WorkingIndex::WorkingIndex() : baseVersionId(-1) {
+}
+
+void WorkingIndex::setIndexPath(const std::string& path) {
+    indexPath = path;
+    clear();
+}
+
+bool WorkingIndex::load() {
+    clear();
+    
+    MappedFile file;
+    if (!file.open(indexPath)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    if (size < WORKING_INDEX_HEADER_SIZE || data[0] != WORKING_INDEX_MAGIC[0] ||
+        data[1] != WORKING_INDEX_MAGIC[1] || data[2] != WORKING_INDEX_MAGIC[2] ||
+        data[3] != WORKING_INDEX_MAGIC[3] || readU32(data + 4) > WORKING_INDEX_VERSION) {
+        return false;
+    }
+    
+    uint32_t version = readU32(data + 4);
+    int loadedBase = static_cast<int>(readU32(data + 8));
+    uint32_t count = readU32(data + 12);
+    size_t pos = WORKING_INDEX_HEADER_SIZE;
+    
+    // The count comes from the file; one that the remaining bytes cannot
+    // hold marks the file as damaged before anything is allocated for it
+    size_t minEntrySize = (version >= 2) ? WORKING_ENTRY_MIN_SIZE + 4 : WORKING_ENTRY_MIN_SIZE;
+    if (count > (size - pos) / minEntrySize) {
+        return false;
+    }
+    entries.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        // Any truncated entry invalidates the whole index
+        if (size - pos < 4) {
+            clear();
+            return false;
+        }
+        size_t nameLength = readU32(data + pos);
+        pos += 4;
+        if (size - pos < nameLength + 20) {
+            clear();
+            return false;
+        }
+        std::string filename(data + pos, nameLength);
+        pos += nameLength;
+        
+        WorkingIndexEntry entry;
+        entry.size = readU64(data + pos);
+        entry.mtime = static_cast<int64_t>(readU64(data + pos + 8));
+        size_t blobLength = readU32(data + pos + 16);
+        pos += 20;
+        if (size - pos < blobLength) {
+            clear();
+            return false;
+        }
+        entry.blobId.assign(data + pos, blobLength);
+        pos += blobLength;
+        
+        entry.removed = false;
+        if (version >= 2) {
+            if (size - pos < 4) {
+                clear();
+                return false;
+            }
+            entry.removed = (readU32(data + pos) & WORKING_ENTRY_REMOVED) != 0;
+            pos += 4;
+        }
+        
+        entries[filename] = entry;
+    }
+    
+    baseVersionId = loadedBase;
+    return true;
+}
+
+bool WorkingIndex::save() const {
+    std::string out;
+    out.append(WORKING_INDEX_MAGIC, 4);
+    appendU32(out, WORKING_INDEX_VERSION);
+    appendU32(out, static_cast<uint32_t>(baseVersionId));
+    appendU32(out, static_cast<uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        appendU32(out, static_cast<uint32_t>(entry.first.size()));
+        out += entry.first;
+        appendU64(out, entry.second.size);
+        appendU64(out, static_cast<uint64_t>(entry.second.mtime));
+        appendU32(out, static_cast<uint32_t>(entry.second.blobId.size()));
+        out += entry.second.blobId;
+        appendU32(out, entry.second.removed ? WORKING_ENTRY_REMOVED : 0);
+    }
+    
+    // Only a cache of hashes, so it is replaced atomically but not synced
+    return FileSync::replaceFile(indexPath, out, false);
+}
+
+void WorkingIndex::clear() {
+    entries.clear();
+    baseVersionId = -1;
+}
+
+int WorkingIndex::getBaseVersionId() const {
+    return baseVersionId;
+}
+
+void WorkingIndex::setBaseVersionId(int versionId) {
+    baseVersionId = versionId;
+}
+
+void WorkingIndex::put(const std::string& filename, const WorkingIndexEntry& entry) {
+    entries[filename] = entry;
+}
+
+void WorkingIndex::remove(const std::string& filename) {
+    entries.erase(filename);
+}
+
+const WorkingIndexEntry* WorkingIndex::find(const std::string& filename) const {
+    auto it = entries.find(filename);
+    if (it != entries.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+const std::unordered_map<std::string, WorkingIndexEntry>& WorkingIndex::getEntries() const {
+    return entries;
+}
+
+std::string WorkingIndex::getCachedBlobId(const std::string& filename, uint64_t size, int64_t mtime) const {
+    const WorkingIndexEntry* entry = find(filename);
+    if (entry && entry->size == size && entry->mtime == mtime) {
+        return entry->blobId;
+    }
+    return "";
+}
\ No newline at end of file
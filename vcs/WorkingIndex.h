@@ -0,0 +1,47 @@
+#ifndef WORKINGINDEX_H
+#define WORKINGINDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+// Cached state of one working file
+struct WorkingIndexEntry {
+    uint64_t size;          // Content length in bytes
+    int64_t mtime;          // When the content last changed (ns since the epoch)
+    std::string blobId;     // Hash of the content seen at (size, mtime); empty if not hashed yet
+    bool removed;           // Deleted since the base commit; size and blobId are unused
+};
+
+// Working tree index kept in <dataPath>/index.bin. It records which commit
+// the working files were checked out from and, for each file edited since,
+// the size and modification time the stored hash belongs to. While those still match,
+// status and commit reuse the hash instead of reading the content again.
+class WorkingIndex {
+private:
+    std::string indexPath;
+    int baseVersionId;      // Commit the working files were checked out from
+    std::unordered_map<std::string, WorkingIndexEntry> entries;
+    
+public:
+    WorkingIndex();
+    
+    void setIndexPath(const std::string& path);
+    
+    bool load();
+    bool save() const;
+    void clear();
+    
+    int getBaseVersionId() const;
+    void setBaseVersionId(int versionId);
+    
+    void put(const std::string& filename, const WorkingIndexEntry& entry);
+    void remove(const std::string& filename);
+    const WorkingIndexEntry* find(const std::string& filename) const;
+    const std::unordered_map<std::string, WorkingIndexEntry>& getEntries() const;
+    
+    // Cached hash for the file if its size and mtime have not changed, else ""
+    std::string getCachedBlobId(const std::string& filename, uint64_t size, int64_t mtime) const;
+};
+
+#endif
\ No newline at end of file